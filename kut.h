@@ -54,6 +54,19 @@ See the following pages for details:
 - \subpage function_test
 - \subpage macros
 - \subpage iterative
+- \subpage parallel
+- \subpage forked
+- \subpage bench
+- \subpage binlog
+- \subpage reporters
+- \subpage timings
+- \subpage autoreg
+- \subpage sharding
+- \subpage property
+- \subpage fastmode
+- \subpage watchdog
+- \subpage alloc
+- \subpage fixtures
 
 \section requi Requirements and limitations
 -# This framework assumes all header files have some common header file, that is included everywhere.
@@ -64,17 +77,19 @@ Then, all you need to do is to add to THIS file the following lines:
 #endif
 \endverbatim
 Alternatively, you can also manually add these lines to all your headers (but this is rather tedious.)
--# The tested classes need to have a default constructor (no arguments).
-This can be a limitation in some situations.
+-# The tested classes need to have a default constructor (no arguments),
+unless the way they are built is given by specializing KUT_FIXTURE_TRAITS (see \ref fixtures).
 -# You need to manually write the 'main()' function that calls all the unit tests (see \ref main).
 While this is ok for a medium-sized projects,
 it will get complicated for large-sized applications with hundreds of classes...
+In that case, the unit tests can register themselves, and be run by a generated main() (see \ref autoreg).
 -# You can not use this for testing a function whose definition lies in the same file as the application 'main()' function.
 This is because you can not have two 'main()' functions in a program, so the file where the "regular" main() lies can not be
 linked to the test application.
 Workaround: move that function to some other file.
 -# You cannot use it to test exception throwing on constructors (for testing exceptions in a general situation, see KUT_TRY_THROW and KUT_TRY_NOTHROW)
--# It \b cannot be used to test templated classes.
+-# Templated classes and functions are tested for a given list of types, with KUT_DEF_TYPED_TEST_METHOD and KUT_TYPED_TEST (see \ref typed).
+-# It needs a C++11 compiler.
 
 
 \section motiv Motivation
@@ -98,6 +113,38 @@ start reading <a href="http://en.wikipedia.org/wiki/Unit_testing" target="w">thi
 
 \section history Release history
 
+- 20261016:
+ - unit tests can be run by several worker threads (see \ref parallel), this requires a C++11 compiler
+ - added KUT_MAIN_START_ARGS, for giving the command line options to KUT
+ - the failure lists and the log line counter are now held by a per-test context (KUT_CONTEXT), the log output of a unit test is buffered
+ and written to the log file when the test ends
+ - added KUT_THREAD_START and KUT_THREAD_END, for using the test macros in threads started inside a unit test
+ - added the "fork" mode, where each unit test runs in its own process (see \ref forked)
+ - added micro-benchmarks macros, and KUT_PERF_LESS to check them against a baseline (see \ref bench)
+ - the log file is now written by a background thread (see KUT_LOG_SINK and the global kut_logsink), and ENDL does not flush the stream anymore.
+ kut_logfile is not a std::ofstream anymore, but a std::ostream writing to the log of the current unit test (see KUT_LOG_STREAM).
+ The code writing to it, or calling flush() and is_open(), is unchanged; the code calling open() or close() must be removed.
+ In case of crash, a signal handler writes the received signal at the end of the log file.
+ - added the binary log file, and the kut-decode tool (see \ref binlog)
+ - added the JUnit XML and NDJSON reporters (see \ref reporters)
+ - each unit test is timed (wall clock, CPU, peak memory), with a table of the slowest tests at the end (see \ref timings)
+ - added automatic registration of the unit tests, KUT_TEST_FUNCTION and KUT_MAIN (see \ref autoreg)
+ - added the selection of the unit tests to run, and the sharding across several machines (see \ref sharding)
+ - added KUT_LOOP_PAR_START, running the iterations of a test loop with several threads (see \ref iterative)
+ - the loop macros use fixed slots, given at run time to each macro by a function-local static, and do not allocate memory anymore
+ - added property tests, with generators and shrinking (see \ref property)
+ - added the fast mode, with test macros reduced to the comparison (see \ref fastmode)
+ - the test macros are thin wrappers around inline functions, with a static description of the test and a single out-of-line handler
+ - values of any type are printed on failure (containers, tuples, optional values, enumerations), with a bounded size and the first mismatching elements of containers
+ - added KUT_EQ_RANGE and KUT_EQ_RANGE_F, comparing contiguous ranges with SIMD instructions
+ - added relative and ULP tolerances (KUT_TOL), KUT_EQ_TOL, KUT_TOL_SCOPE, KUT_EQ_RANGE_TOL, the largest errors at the end of the unit tests; enabled KUT_LESS_F and KUT_EQF_NS
+ - added time budgets for each unit test and for the whole run, enforced by a watchdog (see \ref watchdog)
+ - added allocation tracking, with the allocations of each unit test in the log and the reporters, KUT_ALLOC_SCOPE_MAX and KUT_NO_LEAK (see \ref alloc)
+ - added hardware performance counters (instructions, cycles, cache and branch misses), KUT_PERFCOUNT_START and KUT_PERFCOUNT_LESS (see \ref perfcount)
+ - added fixtures, built once per unit test, per thread or per test program, with reset hooks, also used to build the tested classes (see \ref fixtures)
+ - added typed tests, KUT_TYPED_TEST and KUT_DEF_TYPED_TEST_METHOD, registering one unit test per type (see \ref typed)
+ - added the changed-only mode, not running the unit tests that passed and whose sources have not changed, with a cache file and the compiler dependency files (see \ref cache)
+
 - 20120518:
  - grouped master counting variables under struct KUT_MASTER
 
@@ -196,6 +243,19 @@ int main()
 - \ref function_test
 - \ref macros
 - \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 */
 
 //--------------------------------------------------------------------------------------------
@@ -273,6 +333,19 @@ KUT_DEF_TEST_METHOD( MyClassName )
 - \ref function_test
 - \ref macros
 - \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
 */
 //--------------------------------------------------------------------------------------------
@@ -314,6 +387,19 @@ See demo/testfile.cpp for an example.
 - \ref function_test
 - \ref macros
 - \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
 */
 
@@ -329,18 +415,75 @@ On fail, all of these will have two different behaviors:
 You can select between these two behaviours with the macro KUT_STOP_ON_FAIL, giving it 'true' or 'false' as argument.
 
 Every test macro is provided in two versions:
-- the regular one, that assumes the class provides a stream operator ( << ), to log it's current value. This way, the object
-will be printed out, in case of test failure.
-- the _NS (No Stream) version, for classes which don't have this operator.
+- the regular one, that prints the values in the log file, in case of test failure.
+- the _NS (No Stream) version, that does not print them.
+
+The values are printed by kut_print(), that selects at compile time how to print each type:
+- with its stream operator ( << ), if it has one,
+- else with its member function \c Print(FILE*), if it has one,
+- optional values (as \c std::optional) as \c nullopt or \c optional(value),
+- containers as <code>[a, b, c]</code>, limited to their first KUT_PRINT_MAX_ELEMS elements, followed by their size,
+- tuples and pairs as <code>(a, b)</code>,
+- enumerations as their underlying value,
+- anything else as its size and its first bytes.
+
+The printed values are limited to KUT_PRINT_MAX_LENGTH characters.
+When two containers are compared, the first mismatching elements (at most KUT_PRINT_MAX_DIFF) and the sizes are also printed:
+\verbatim
+ * Test 1 (0.1), line: 18: FAIL (1), on line 18 of file test.cpp, expression: a == b
+  -first value : "a" = "[1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, ... (1000 elements)]"
+  -second value: "b" = "[1, 1, 1, 7, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, ... (1003 elements)]"
+  -mismatch at index 3: 1 != 7
+  -mismatch at index 500: 1 != 2
+  -sizes differ: 1000 and 1003
+\endverbatim
 
 
 List of macros:
-- KUT_EQ_F : testing of equality of floating point values, using absolute value KUT_EPSILON
+- KUT_EQ_F : testing of equality of floating point values, using the current tolerance (by default, absolute value KUT_EPSILON)
+- KUT_EQ_TOL : testing of equality of floating point values, using a given tolerance
 - KUT_LESS_F : testing ordering of two floating point values
 - KUT_EQ : testing of equality of 2 objects, using their defined (!) == operator
 - KUT_DIFF : testing of inequality of 2 objects, using their defined (!) != operator
 - KUT_LESS : testing ordering of two objects, using their defined '<' operator
 - KUT_TRUE : asserting an expression or an object/value
+- KUT_EQ_RANGE : testing equality of two contiguous ranges (vectors, arrays, ...), element by element
+- KUT_EQ_RANGE_F : testing equality of two contiguous ranges of floating point values, with a given absolute tolerance
+- KUT_EQ_RANGE_TOL : testing equality of two contiguous ranges of floating point values, with a given tolerance
+- KUT_ALLOC_SCOPE_MAX : limiting the nb of allocations of a block of code (see \ref alloc)
+- KUT_NO_LEAK : asserting that a block of code frees all the memory it allocates (see \ref alloc)
+
+The range macros search the first mismatching element with SIMD instructions (SSE2, or AVX2 if the code is built with it, see KUT_NO_SIMD)
+for integers, enumerations, pointers and floating point values.
+On fail, they log the sizes of the ranges and the first KUT_RANGE_MAX_REPORT mismatching elements, with their index and values.
+By default, the search stops there; after <code>KUT_RANGE_COUNT_ALL( true );</code>, the whole ranges are scanned and the number of mismatching elements is also logged:
+\verbatim
+ * Test 3 (1.3), line: 31: FAIL (1), on line 31 of file test.cpp, expression: x == y
+  -mismatch at index 0: 1 != 2
+  -mismatch at index 7: 1 != 2
+  ...
+  -143 mismatching elements out of 1000 (14.3 %)
+\endverbatim
+
+The tolerance of the floating point comparisons (KUT_TOL) can be absolute, relative, or a distance in units in the last place (ULP),
+and these can be combined:
+\code
+	KUT_EQ_TOL( x, 1./3., kut_rel( 1E-12 ) | kut_ulp( 4 ) );
+	{
+		KUT_TOL_SCOPE( kut_rel( 1E-6 ) );    // for all the KUT_EQ_F until the end of the scope
+		KUT_EQ_F( y, 2. );
+	}
+	KUT_EQ_RANGE_TOL( v_result, v_expected, kut_abs( 1E-9 ) | kut_rel( 1E-7 ) );
+\endcode
+
+In verbose mode, the largest errors measured by each of these comparisons (in the thread running the test) are written at the end of the unit test,
+to help adjusting the tolerances:
+\verbatim
+ - Largest errors of the floating-point comparisons:
+   - line 28 of file test.cpp: 1003 values, abs: 3.99996e-09, rel: 4.00001e-12, tolerance: rel 1e-11
+   - line 31 of file test.cpp: 1 values, abs: 2.38419e-07, rel: 2.38419e-07, ulp: 2, tolerance: ulp 4
+\endverbatim
+The range macros check the absolute and relative tolerances with SIMD instructions, and do not measure the ULP distances.
 
 To be continued...
 
@@ -352,6 +495,19 @@ To be continued...
 - \ref function_test
 - \ref macros
 - \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
 */
 
@@ -384,6 +540,34 @@ For example, this will only count as one test in the log file, even if actually
 At the end of the test, a log of each tests failure rate will be printed out in the log file.
 Please note that this will happen only in 'verbose' mode (see \ref verbose), if not, only one failure
 will be reported at the line where KUT_LOOP_END stays. In this case, you need to re-run using verbose mode.
+For each expression that failed, the report gives the first iteration (value of \c kut_i) where it failed.
+
+Each loop macro gets a slot in a fixed-size array of counters (held by a function-local static, given the first time the macro is reached),
+and a static description of its expression,
+so a loop does not allocate any memory, and an iteration only costs the comparisons (and one increment for each failure).
+A loop can hold at most KUT_LOOP_MAX_SITES loop macros (default: 32, can be defined before including kut.h):
+the failures of the ones after are still counted for the loop, but are not reported one by one.
+
+\section loop_par Parallel loops
+If the iterations are independent, they can be run by several threads, by starting the loop with KUT_LOOP_PAR_START instead of KUT_LOOP_START
+(the loop still ends with KUT_LOOP_END).
+The iterations are split in chunks of consecutive indexes, taken by KUT_LOOP_PAR_JOBS worker threads (default: one per core).
+Each thread has its own failure counters, added at the end, so the report is the same as the one of a serial loop.
+
+The body is run in a lambda, so:
+ - it must only use the loop macros (KUT_LOOP_TRUE, KUT_LOOP_EQU, ...), not the other test macros,
+ - it must run the same loop macros, in the same order, at every iteration,
+ - the variables declared outside the loop are shared by the threads,
+ - random values should be computed from \c kut_i, so that a failing iteration can be run again alone:
+\code
+	KUT_LOOP_PAR_START( 1000000 )
+	{
+		std::mt19937 rng( kut_i );
+		double x = std::uniform_real_distribution<double>( 0., 1. )( rng );
+		KUT_LOOP_LESS( my_sqrt( x ), 1.0000001 );
+	}
+	KUT_LOOP_END;
+\endcode
 
 <hr>
 \b Navigation
@@ -393,754 +577,6474 @@ will be reported at the line where KUT_LOOP_END stays. In this case, you need to
 - \ref function_test
 - \ref macros
 - \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
 */
 
-//-------------------------------------------------------------------------------------------
-// this is the "real" beginning of file...
-#ifndef _KUT_H_
-#define _KUT_H_
+//--------------------------------------------------------------------------------------------
+/**
+\page parallel Running the unit tests in parallel
 
-#include <iostream>
-#include <fstream>
-#include <cstdio>
-#include <cstdlib>
-#include <ctime>
-#include <vector>
-#include <string>
-#include <cassert>
-#include <cmath>
+By default, each unit test (KUT_TEST_CLASS, KUT_TEST_FUNC) is run right away, one after the other.
+On a multi-core machine, the unit tests can be spread across several worker threads, by giving their number:
+- either with the environment variable \c KUT_JOBS,
+- or with the command line option \c --jobs=N (or \c -jN), if the test main uses KUT_MAIN_START_ARGS instead of KUT_MAIN_START:
 
-//#include <ios>
+\code
+int main( int argc, char** argv )
+{
+	KUT_MAIN_START_ARGS( argc, argv );
 
+	KUT_TEST_CLASS( ClassA );
+	KUT_TEST_FUNC( MyTestFunc );
 
-/// current version of file, printed in logfile
-#define KUT_VERSION "20120518"
+	KUT_MAIN_END;
+}
+\endcode
 
-//-------------------------------------------------------------------------------------------
-/// \name User interface macros
-//@{
+A value of 0 means "one worker per core".
 
-/// epsilon value for testing of equality of floating-point values (see KUT_EQF)
-#ifndef KUT_EPSILON
-	#define KUT_EPSILON 1e-9
-#endif
+In this mode, KUT_TEST_CLASS and KUT_TEST_FUNC only queue the unit tests, and they are all run by KUT_MAIN_END.
+Each unit test has its own context (KUT_CONTEXT), holding its failure list and a buffer for its log output,
+so the test macros never need to take a lock.
+When a unit test ends, the results of the tests that have ended before the first one still running are merged in KUT_MASTER,
+in the order the tests were queued: the progress is shown while the tests run, and the summary, the log file and the returned value are the same as with a serial run
+(except the "TEMP" line numbers inside a unit test, that are not written: the line of the log file is only known once the test is merged).
 
-/// the logfile name, to be changed if (really ?) needed
-#ifndef KUT_FILENAME
-	#define KUT_FILENAME "kut_logfile.txt"
-#endif
+Requirements:
+- the unit tests must not depend on each other, as they may run in any order, or simultaneously.
+- always write to the log file with KUT_LOG/KUT_LOG2.
+- if a unit test starts threads that use the test macros, use KUT_THREAD_START and KUT_THREAD_END inside these threads.
 
-/// defining this to true will enable the 'verbose' mode
-#ifndef KUT_VERBOSE_MODE
-	#define KUT_VERBOSE_MODE true
-#endif
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
-/// a shorthand logfile
-/**
-This macro also increments the log file line counter, to keep track of where the failure occurs (printed at the end of all tests)
 */
-#define KUT_LOG kut_line_counter++; kut_logfile
 
-/// This one does not increment the counter
-#define KUT_LOG2 kut_logfile
+//--------------------------------------------------------------------------------------------
+/**
+\page forked Running each unit test in its own process
 
-/// a shorthand for std::endl
-#ifndef ENDL
-	#define ENDL std::endl
-#endif
+When a unit test crashes (segfault, uncaught exception, ...), the whole test application ends, and the results of the following unit tests are lost.
 
+On posix systems, the fork mode avoids this: it is enabled with the command line option \c --fork (see KUT_MAIN_START_ARGS),
+or by setting the environment variable \c KUT_FORK to 1.
+Each unit test is then run in its own child process, that sends its counters, its failure list and its log output
+back to the test application through a pipe.
+If the child process gets killed by a signal, the unit test is recorded as failed, and the other unit tests go on.
 
-/// User macro, if called with 'true', then a failing test will interrupt current unit-test
-/**
-This is mostly useful when tracking down a bug: instead of letting the whole test suite run each time,
-if you stop immediatly after the failed test, you can right away check the last lines of the log file
-to see your debug output, instead of having to go through (potential) thousands of debug lines.
-*/
-#define KUT_STOP_ON_FAIL( a ) \
-	if( a ) \
-	{ \
-		KUT_LOG << " - Switching to mode \"StopTestOnFail\" : ON\n"; \
-		kut_data.StopTestOnFail = true; \
-	} \
-	else \
-	{ \
-		KUT_LOG << " - Switching to mode \"StopTestOnFail\" : OFF\n"; \
-		kut_data.StopTestOnFail = false; \
-	} \
+Up to \c N child processes run at the same time, with \c N given as for the worker threads (see \ref parallel).
+The results are merged in the order the unit tests were queued, as with the worker threads.
 
-//@}
+The time budgets (see \ref watchdog) apply to the child processes: a child process over its budget sends its results at its next test,
+or gets killed, and its unit test is recorded as failed. The other unit tests go on.
 
-extern std::vector<std::string>  kut_fail_file;
-extern std::vector<unsigned int> kut_fail_line;
-extern bool                      kut_verbose;
-extern size_t                    kut_line_counter;
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
-//-------------------------------------------------------------------------------------------
-/// Internal data structure used, holds several counters.
-struct KUT_MASTER
-{
-	int NbTestTot;
-	int NbFailureTot;
-	int NbUnitTests;
-	int NbUTFailures;
-	std::vector<std::string> v_failed_test_name;    ///< name of class/function whose test failed
-	std::vector<int>         v_failed_test_type;    ///< 0 for a class, 1 for a function
-	std::vector<size_t>      v_failed_test_logline; ///< logfile line where this failure is reported, see kut_line_counter
-	KUT_MASTER()
-	{
-		NbTestTot    = 0;
-		NbFailureTot = 0;
-		NbUnitTests  = 0;
-		NbUTFailures = 0;
-	}
+*/
 
-};
+//--------------------------------------------------------------------------------------------
+/**
+\page bench Micro-benchmarks
 
-//-------------------------------------------------------------------------------------------
-/// Internal data structure used, holds several counters related to the current unit-test.
-struct KUT_TYPE
-{
-	int  count_fail; ///< Nb of tests that failed.
-	int  count_test; ///< Total nb of tests
-	int  count_test1; ///< major text counter
-	int  count_test2; ///< minor text counter
-	bool StopTestOnFail;
-	bool DoQuit;
-	bool kut_failflag; ///< used to communicate failure between different parts of macros
+Some performance checks can be written with the KUT_BENCH_START / KUT_BENCH_END macros.
+The code in between is run repeatedly, and the statistics of the duration of one iteration
+(minimum, median, 99th percentile and standard deviation) are printed in the log file.
 
-//-------------------------------------------------------------------------------------------
-/// Constructor, initialises all the fields
-	KUT_TYPE()
+\code
+	std::vector<int> v( 1000 );
+	KUT_BENCH_START( "sort 1000 int", 10000, 0.5 ) // at least 10000 iterations, during at least 0.5 s
 	{
-		count_fail  = 0;
-		count_test1 = 0;
-		count_test2 = 0;
-		count_test  = 0;
-		StopTestOnFail = false;
-		DoQuit = false;
-		kut_failflag = false;
+		std::vector<int> v2( v );
+		std::sort( v2.begin(), v2.end() );
+		KUT_DO_NOT_OPTIMIZE( v2 );
 	}
-};
+	KUT_BENCH_END;
+\endcode
 
-//-------------------------------------------------------------------------------------------
-/// User needs to put this at the beginning of his main test file (global allocation)
-#define KUT_ALLOC \
-	std::vector<std::string>  kut_fail_file; \
-	std::vector<unsigned int> kut_fail_line; \
-	bool                      kut_verbose = KUT_VERBOSE_MODE; \
-	std::ofstream             kut_logfile; \
-	size_t                    kut_line_counter = 0
+Before measuring, the nb of iterations per sample is calibrated (see KUT_BENCH_SAMPLE_TIME), and some warm-up samples are run (see KUT_BENCH_WARMUP).
+The durations are measured with a monotonic clock (\c std::chrono::steady_clock).
 
-/// so that test function are aware of this global
-extern std::ofstream kut_logfile;
+As the compiler may remove code whose result is not used, use KUT_DO_NOT_OPTIMIZE( value ) on the results of the measured code,
+and KUT_CLOBBER() to keep the writes to memory.
 
-//-------------------------------------------------------------------------------------------
-/// \name Private macros, do not use in your code
-//@{
+\section baseline Performance regressions
+The median duration of a benchmark can be checked against a reference value, with KUT_PERF_LESS( name, tolerance_pct ),
+that is a test failing if the benchmark \c name, run before in the same unit test, is slower than its reference by more than \c tolerance_pct percent:
+\code
+	KUT_PERF_LESS( "sort 1000 int", 10 ); // fails if more than 10% slower
+\endcode
+If there is no reference value for this benchmark, the test passes.
 
-/// Private macro
-/**
-\todo return statement at the end is never executed !
-*/
-#define KUT_P_FAILURE \
-	{ \
-		kut_data.count_fail++; \
-		if( kut_verbose ) \
-		{ \
-			KUT_LOG << "FAIL (" << kut_data.count_fail << "), on line "; \
-			KUT_LOG2 << __LINE__ << " of file " << __FILE__; \
-		} \
-		kut_data.kut_failflag = true; \
-		kut_fail_file.push_back( __FILE__ ); \
-		kut_fail_line.push_back( __LINE__ ); \
-		if( kut_data.StopTestOnFail ) \
-		{ \
-			std::cout << " -premature ending of test !\n"; \
-			kut_data.DoQuit = true; \
-			KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n";\
-			KUT_LOG << " - in function : " << __PRETTY_FUNCTION__ << ENDL; \
-			KUT_LOG << " - Actual status : " << kut_data.count_test <<" tests done and " << kut_data.count_fail<<" failure(s)\n\n"; \
-			exit(1); \
-		} \
-	}
+The reference values are read by KUT_MAIN_START from the baseline file (KUT_BASELINE_FILENAME, or given with the command line option \c --baseline=file).
+With the option \c --update-baseline, this file is rewritten by KUT_MAIN_END with the durations measured (the benchmarks that were not run keep their previous value).
 
-/// Common code, to do right after the test
-#define KUT_P11 \
-		{ \
-			if( kut_verbose ) \
-				KUT_LOG2 << "PASS"; \
-		} \
-		else \
-		{ \
-			KUT_P_FAILURE \
-		} \
+A benchmark itself does not count as a test. Remember that unit tests run in parallel (see \ref parallel) will disturb each other's timings.
 
-/// streams value of the 2 arguments to log file, if test failed
-#define KUT_P_STREAM_VALUES( a, b ) \
-		if( kut_data.kut_failflag && kut_verbose ) \
-		{ \
-			KUT_LOG << "  -first value : \"" << #a << "\" = \"" << (a) << "\"" << ENDL; \
-			KUT_LOG << "  -second value: \"" << #b << "\" = \"" << (b) << "\"" << ENDL; \
-		}
+\section perfcount Hardware performance counters
+Durations are noisy on shared machines, while the number of instructions run by some code hardly changes from one run to the other.
+On Linux, the code between KUT_PERFCOUNT_START and KUT_PERFCOUNT_END is measured with the hardware performance counters of the thread
+(read with \c perf_event_open(), user space only): instructions, cycles, cache misses and branch misses.
+It is run once first, not measured, then \c nb times (second argument), and the counts per call are printed in the log file:
+\code
+	KUT_PERFCOUNT_START( "dot 1024", 100 )
+	{
+		KUT_DO_NOT_OPTIMIZE( dot( a, b, 1024 ) );
+	}
+	KUT_PERFCOUNT_END;
+	KUT_PERFCOUNT_LESS( "dot 1024", KUT_PC_INSTRUCTIONS, 1500 );
+	KUT_PERFCOUNT_LESS( "dot 1024", KUT_PC_BRANCH_MISSES, 5 );
+\endcode
+\verbatim
+ * Counters "dot 1024": 100 calls, instructions: 1294, cycles: 701.4, cache misses: 0.02, branch misses: 1.01 per call
+\endverbatim
 
-/// prepare test
-#define KUT_P2 \
-		kut_data.count_test++; \
-		kut_data.count_test2++; \
-		if( kut_verbose ) \
-		{ \
-			KUT_LOG << std::dec<< " * Test " << kut_data.count_test << " (" << kut_data.count_test1 << "." << kut_data.count_test2 <<"), line: " << __LINE__  << ": "; \
-		} \
-		kut_data.kut_failflag = false
+KUT_PERFCOUNT_LESS( name, counter, max ) is a test, failing if the counter (see KUT_PC) of the scope \c name, run before in the same unit test,
+is above \c max per call. It fails too if the scope was not run.
 
-/// Private macro for comparing (== operator)
-#define KUT_P_EQ( a, b ) \
-	KUT_P2; \
-	if( (a) == (b) ) \
-		KUT_P11 \
-	if( kut_verbose ) \
-		KUT_LOG2 << ", expression: " << #a << " == " << #b << ENDL
+The counters may not be available: not on Linux, no hardware counters (most virtual machines), or not permitted
+(see \c /proc/sys/kernel/perf_event_paranoid, that must be 2 or less). They are then logged as "not available",
+and the tests on them pass, so the same tests run everywhere and only gate where the counters can be read.
+Define KUT_NO_PERFCOUNT to never use them.
 
-/// Private macro for difference operator
-#define KUT_P_DIFF( a, b ) \
-	KUT_P2; \
-	if( (a) != (b) ) \
-		KUT_P11 \
-	if( kut_verbose ) \
-		KUT_LOG2 << ", expression: " << #a << " != " << #b << ENDL
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
-/// Private macro for comparing (< operator)
-#define KUT_P_LESS( a, b ) \
-	KUT_P2; \
-	if( (a) < (b) ) \
-		KUT_P11 \
-	if( kut_verbose ) \
-		KUT_LOG2 << ", expression: " << #a << " < " << #b << ENDL
+*/
 
-/// Private macro for 'true' test
-#define KUT_P_TRUE( a ) \
-	KUT_P2; \
-	if( a ) \
-		KUT_P11; \
-	if( kut_verbose ) \
-		KUT_LOG2 << ", expression: " << #a << " is TRUE" << ENDL \
+//--------------------------------------------------------------------------------------------
+/**
+\page binlog Binary log file
 
-/// Private macro for 'false' test
-#define KUT_P_FALSE( a ) \
-	KUT_P2; \
-	if( false == (a) ) \
-		KUT_P11; \
-	if( kut_verbose ) \
-		KUT_LOG2 << ", expression: " << #a << " is FALSE" << ENDL \
+When a test program runs many tests, most of its time can be spent formatting and writing the text log file.
+With the option \c --binlog=file (or the environment variable \c KUT_BINLOG), each test is instead recorded as a fixed-size binary record,
+and the verbose text output is disabled (failure messages are still written to the text log file).
+\code
+./mytests --binlog=tests.bin
+\endcode
 
-//#define KUT_P_DOQUIT if(kut_data.DoQuit == true) exit(1)
+The file can then be read offline with the \c kut-decode tool (build it with <code>make kut-decode</code>):
+\verbatim
+kut-decode tests.bin                  # all the tests
+kut-decode --failures tests.bin       # only the failed tests
+kut-decode --summary tests.bin        # one line per unit test
+kut-decode --filter=MyClass tests.bin # only the unit tests whose name contains "MyClass"
+\endverbatim
+It returns 1 if some test failed, 2 if the file can not be read.
 
-///@}
+\section binlog_format File format
+All values are in native byte order.
+The file starts with the characters \c KUTBIN1 followed by a null byte and the size of a record (uint32), then a sequence of chunks, each starting with a uint32 type:
+ - \c KUT_BIN_STRING: an entry of the string table (file names, expressions, unit test names), each string is written once, before its first use
+ - \c KUT_BIN_UNIT_TEST: a unit test, with its counters
+ - \c KUT_BIN_RECORDS: the records (see KUT_BIN_RECORD) of the tests done by the previous unit test: operator, pass/fail, file and line, expression, and time since the beginning of the run.
 
-//-------------------------------------------------------------------------------------------
-/// \name Set of macros to be used inside the test function
-//@{
+Unit tests are written in the order they are added, also in parallel and fork modes (see \ref parallel).
 
-/// A macro useful for documenting the test log file. Argument is a string. Increments counter 1
-#define KUT_MSG( a ) \
-	{ \
-		kut_data.count_test1++; \
-		if( kut_verbose ) \
-		{ \
-			KUT_LOG << ENDL; \
-			KUT_LOG <<std::dec<< "* Test msg (" << kut_data.count_test1 << "): " << (a) << " TEMP "<< kut_line_counter << ENDL; \
-			std::cerr <<std::dec<< "* Test msg (" << kut_data.count_test1 << "): " << (a) << ENDL; \
-		} \
-		kut_data.count_test2 = 0; \
-	}
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
 
-/// Testing equality of floating point values, using absolute epsilon value KUT_EPSILON.
-/// You need to include math.h in your code if you want to use this macro (uses \c fabs() ).
-/// Streams values in output file on fail.
-/** Requirement: \c a and \c b need to have the '-' operator defined, and it needs to return a floating-point value.
 */
-#define KUT_EQ_F( a, b ) \
-	{ \
-		KUT_P2; \
-		if( fabs( (a) - (b) ) < KUT_EPSILON ) \
-			KUT_P11 \
-		if( kut_verbose ) \
-			KUT_LOG << ", expr: " << #a << " == " << #b << ENDL; \
-		KUT_P_STREAM_VALUES( a, b ); \
-	}
 
-// Testing ordering of floating point values, using '<'. You need to include math.h in your code if you want to use this macro.
-// Streams values in output file on fail.
-/*
-#define KUT_LESS_F( a, b ) \
-	{ \
-		KUT_P2; \
-		if( fabs( (a) < (b) ) ) \
-			KUT_P11 \
-		KUT_LOG << ", expr: " << #a << " < " << #b << ENDL; \
-		KUT_P_STREAM_VALUES( a, b ); \
-	}
-*/
+//--------------------------------------------------------------------------------------------
+/**
+\page reporters Reporters
 
+Besides the log file, the results can be written for a continuous integration system, with one or several reporters:
+ - <code>--junit=file</code> (or the environment variable \c KUT_JUNIT): JUnit XML file. Each unit test is a \c testsuite holding a single \c testcase, with its duration, its nb of tests (attribute \c assertions),
+and a \c failure element with <code>file:line</code> for each failed test.
+ - <code>--json=file</code> (or \c KUT_JSON): NDJSON file, one JSON object per line:
+\verbatim
+{"event":"start","version":"20261016"}
+{"event":"test","id":1,"name":"MyClass","type":"class","duration":0.0012,"assertions":8,"failures":1,"failed_at":[{"file":"myclass.cpp","line":9}]}
+{"event":"end","unit_tests":1,"unit_test_failures":1,"tests":8,"failures":1}
+\endverbatim
+The unit tests not run as unchanged since they passed (see \ref cache) are reported with TestCached().
 
+The reporters write their output as soon as each unit test is done, so it can be followed while the tests are running, and the memory used does not grow with the nb of tests.
+In parallel and fork modes (see \ref parallel), unit tests are reported in the order they were added, once all the ones added before are done.
 
-/// Testing equality of 2 objects, by using its '==' operator. Streams values in output file on fail.
+You can add your own reporter, by inheriting from KUT_REPORTER and adding it after KUT_MAIN_START:
+\code
+struct MyReporter : public KUT_REPORTER
+{
+	void TestEnd( int id, const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data ) { ... }
+	void RunEnd( int nb_unit_tests, int nb_ut_failures, int nb_tests, int nb_failures ) { ... }
+};
+
+KUT_MAIN_START;
+kut_m.AddReporter( new MyReporter );
+\endcode
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page timings Timings of the tests
+
+Each unit test (KUT_TEST_CLASS, KUT_TEST_FUNC), and each function called with KUT_EXECFUNC, is measured:
+ - wall clock time,
+ - user and system CPU times (\c getrusage(), of the thread running the test when the system provides it, so the threads started by the test are not counted),
+ - increase of the peak resident set size of the process.
+This one is only meaningful in serial and fork modes, as in parallel mode the memory is shared by the tests running at the same time.
+On non-POSIX systems, only the wall clock time and the CPU time of the process (\c std::clock()) are available.
+
+At the end, the table of the slowest ones is printed to the log file and to stdout:
+\verbatim
+ - Slowest tests:
+        wall        user         sys  peak RSS +kB  name
+  122.391 ms     52.3 ms    31.38 ms         51916  function TestFunc1
+   122.28 ms   51.365 ms    30.89 ms         51200  local function TestFunc1/Local( kut_data )
+\endverbatim
+Options:
+ - <code>--slowest=N</code> (or the environment variable \c KUT_SLOWEST): nb of lines of this table (default 10, 0 to remove it),
+ - <code>--timings=file</code> (or \c KUT_TIMINGS): writes all the timings, one per line, separated by tabulations:
+<code>wall user sys rss_kb type name</code>, times in seconds, type being 0 for a class, 1 for a function, 2 for a function called with KUT_EXECFUNC.
+
+The NDJSON reporter (see \ref reporters) also gives these values for each unit test.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page autoreg Automatic registration of the unit tests
+
+Instead of writing the main() function by hand (see \ref main), the unit tests can register themselves:
+ - the class test methods defined with KUT_DEF_TEST_METHOD are registered,
+ - the test functions are defined with KUT_TEST_FUNCTION (instead of a regular function called with KUT_TEST_FUNC):
+\verbatim
+// file : foo_test.cpp
+#include "kut.h"
+
+KUT_TEST_FUNCTION( TestFoo )
+{
+	KUT_FT_START( foo );
+	KUT_EQ( foo(1), 2 );
+	KUT_FT_END;
+}
+\endverbatim
+
+The main test file then only holds:
+\verbatim
+#include "kut.h"
+KUT_MAIN
+\endverbatim
+KUT_MAIN defines the main() function, that runs all the registered unit tests, sorted by file name and line.
+So a test program only runs the tests of the files it is linked with, and adding a test file to a program does not need any other change.
+
+Options of the generated program, besides those described in \ref parallel, \ref reporters and \ref timings:
+ - <code>--list</code>: prints the registered unit tests, and exits,
+ - <code>--shuffle</code>, <code>--shuffle=seed</code>: runs the unit tests in a random order, the seed being printed so that an order can be reproduced.
+With shards (see \ref sharding), each shard is selected before shuffling, so the shards do not depend on the seed.
+
+A hand-written main() still works as before: it only runs the unit tests it adds with KUT_TEST_CLASS and KUT_TEST_FUNC,
+and can add the registered ones with <code>kut_m.AddRegisteredTests();</code>.
+
+\section typed Typed tests
+A test written once can be run for several types with KUT_TYPED_TEST( name, types... ), that defines a test function template,
+whose type parameter is \c T:
+\verbatim
+KUT_TYPED_TEST( TestSum, float, double, int8_t, int16_t )
+{
+	KUT_FT_START( sum );
+	std::vector<T> v( 10, T(1) );
+	KUT_EQ( sum( v ), T(10) );
+	KUT_FT_END;
+}
+\endverbatim
+It is instantiated at compile time for each type, and each instance is registered as a unit test of its own,
+named with its type as written in the list: \c TestSum<float>, \c TestSum<double>, ...
+So they are reported, selected (<code>--filter='TestSum<*'</code>) and run in parallel as any other unit test,
+and the code run for a type is the one compiled for it, without any run-time dispatch.
+Types holding commas, such as <code>Vec<float,4></code>, can be given as they are.
+
+A class template with one type parameter, holding KUT_CLASS_DECLARE (see \ref class_test), is tested the same way,
+its test method being defined with KUT_DEF_TYPED_TEST_METHOD:
+\verbatim
+KUT_DEF_TYPED_TEST_METHOD( SmallVector, float, double )
+{
+	KUT_CTM_START( SmallVector );
+	SmallVector<T> v;
+	v.push_back( T(2) );
+	KUT_EQ( v.size(), 1 );
+	KUT_CTM_END;
+}
+\endverbatim
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page sharding Selecting the tests, and sharding
+
+\section filter Filter
+With <code>--filter=patterns</code> (or the environment variable \c KUT_FILTER), only the unit tests whose name matches are run.
+Patterns are globs (\c * matches any sequence of characters, \c ? any character), separated by \c ':'.
+As with googletest, the patterns after the first \c '-' exclude the matching tests (no positive pattern meaning all the tests):
+\verbatim
+./mytests --filter='Matrix*:Vector*'
+./mytests --filter='*-*Slow*'        # all, except those whose name contains "Slow"
+./mytests --filter='-*Slow*:*Big*'   # all, except those whose name contains "Slow" or "Big"
+\endverbatim
+
+\section shards Shards
+To split a run across several machines, each one runs the same program with <code>--shard-count=N --shard-index=i</code>, \c i in <code>[0,N[</code>
+(or \c KUT_SHARD_COUNT and \c KUT_SHARD_INDEX).
+By default, the unit tests matching the filter are dealt in turn: the \c k-th goes to the shard <code>k % N</code>.
+
+If the durations of the unit tests are very different, the shards can be balanced with the timings file of a previous run (see \ref timings),
+with <code>--shard-timings=file</code> (or \c KUT_SHARD_TIMINGS).
+The unit tests are then taken by decreasing duration, each one going to the shard with the smallest total duration so far,
+tests missing in the file getting the mean duration.
+As ties are broken by name, every machine computes the same split, as long as they all use the same timings file.
+\verbatim
+./mytests --timings=timings.txt                                                  # once, on any machine
+./mytests --shard-count=16 --shard-index=$NODE --shard-timings=timings.txt       # on each machine
+\endverbatim
+All the unit tests then need to be added before any one is run, so they are queued and run by KUT_MAIN_END, as in parallel mode (see \ref parallel).
+
+In all cases, the counters, the summary and the return value of the program only cover the unit tests run by this program.
+The nb of unit tests skipped is given at the end.
+
+\section cache Running only the changed tests
+With <code>--changed-only</code> (or the environment variable \c KUT_CHANGED_ONLY=1), a registered unit test (see \ref autoreg)
+is not run if it passed on its last run, and if the file defining it and the files this one depends on have not changed since.
+
+The dependencies are read from the dependency files written by the compiler with the option \c -MD (gcc, clang),
+searched in the directory given with <code>--depdir=dir</code> (or \c KUT_DEPDIR, default: the current directory) and its sub-directories.
+The content of the source file of the test and of each of its dependencies is hashed, and compared to the hash stored in the cache file
+(KUT_CACHE_FILENAME, or <code>--cache=file</code>), that also holds the last result of each unit test.
+This file is rewritten at the end of each run in this mode.
+\verbatim
+g++ -MD -DTESTMODE -c test_foo.cpp ...      # writes test_foo.d next to test_foo.o
+./mytests --changed-only --depdir=build
+\endverbatim
+
+The unit tests skipped are reported as cached: a line in the log file, an event \c cached in the NDJSON file,
+a \c skipped element in the JUnit file (see \ref reporters), and their nb in the summary.
+
+Notes:
+ - the paths are those given to the compiler, so the test program has to be run from the directory they are relative to (or use absolute paths),
+ - a unit test whose sources can not be read is always run, and so are the unit tests added with KUT_TEST_CLASS and KUT_TEST_FUNC, as their file is not known,
+ - only the translation unit of the test is followed: a change in a function defined in another \c .cpp file is not seen. So this is meant for a local edit-test cycle,
+a full run being still needed before committing.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page property Property tests
+
+A property test checks that a property holds for many generated values, and when it does not, reports a minimal counterexample.
+The property is written after KUT_PROPERTY, as the parameters and the body of a lambda returning true if the property holds,
+each parameter getting its values from a generator:
+\code
+	KUT_PROPERTY( sum_is_bounded, 100000, kut_gen_int( -1000, 1000 ), kut_gen_vector( kut_gen_int( 0, 100 ), 0, 20 ) )
+	( int a, const std::vector<int>& v ) -> bool
+	{
+		return my_sum( a, v ) < 500;
+	};
+\endcode
+(note the semicolon at the end)
+
+Available generators:
+ - <code>kut_gen_int( lo, hi )</code>: integers in <code>[lo,hi]</code>, of the type of \c lo and \c hi,
+ - <code>kut_gen_float( lo, hi )</code>: floating point values in <code>[lo,hi[</code>,
+ - <code>kut_gen_string( min_len, max_len [, charset] )</code>: strings, by default of printable ASCII characters,
+ - <code>kut_gen_vector( generator, min_len, max_len )</code>: vectors, whose elements are given by another generator.
+
+A generator is a class with a \c value_type, an <code>operator()( KUT_RNG&, value_type& )</code> filling a value, and a
+<code>Shrink( const value_type&, std::vector<value_type>& )</code> giving simpler values to try, so you can write your own.
+
+A property counts as one test.
+If it fails (returns false, or throws an exception), the failing case is shrunk: the simpler values given by the generators
+are tried, as long as the property still fails (at most KUT_PROPERTY_MAX_SHRINK tries).
+In verbose mode, the smallest counterexample found is logged with the seed:
+\verbatim
+ * Test 2 (0.2), line: 14: FAIL (1), on line 14 of file prop.cpp, property sum_is_bounded, case 2 of 100000, shrunk after 96 tries
+  -first value : "counterexample" = "(0, [33, 32, 6, 79, 79, 23, 73, 57, 43, 75])"
+  -second value: "seed" = "0"
+\endverbatim
+
+The values are reproducible: each case has its own random generator, seeded from the index of the case, the name of the property,
+and the global seed, given by the environment variable \c KUT_SEED (or else by the macro KUT_SEED, 0 by default).
+Running with another seed gives other values.
+
+The cases are generated by batches of KUT_PROPERTY_BATCH, reusing the memory of strings and vectors from one batch to the next,
+so a simple property can be checked for hundreds of millions of cases per second.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page fastmode Fast mode
+
+Each test macro holds the code writing the log of the test, even if the verbose mode is disabled at run time (see KUT_VERBOSE_MODE).
+With many tests, this makes the test programs long to build, and big.
+
+If \c KUT_FAST_MODE is defined before including kut.h (or on the command line of the compiler, <code>-DKUT_FAST_MODE</code>):
+ - the verbose mode is disabled,
+ - the test macros (KUT_EQ, KUT_DIFF, KUT_LESS, KUT_TRUE, KUT_FALSE, KUT_EQ_F, and their variants) are reduced to the comparison
+and the increment of the counter,
+ - when a test fails, an out-of-line function marked as cold, kut_report(), gets a static description of the test (KUT_SITE: file, line, expression, operator),
+and writes one line to the log file:
+\verbatim
+ * Test 2: FAIL (1), on line 9 of file classA.cpp, expression: a1 == a2
+\endverbatim
+
+So in this mode:
+ - the values of the arguments are not written to the log file on failure,
+ - KUT_MSG only increments the counters,
+ - the binary log file (see \ref binlog) only holds the tests that failed,
+ - the tests do not check the time budget (see \ref watchdog): a unit test over its budget is recorded as failed when it ends,
+and one that never ends is stopped by the watchdog after the grace delay, without the location of its last test.
+
+Counters, summary, and the list of failures at the end of each unit test are the same as in the normal mode.
+KUT_FAST_MODE needs to be defined the same way in all the files of the test program.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page watchdog Time budgets of the unit tests
+
+A unit test that hangs (deadlock, endless loop, ...) would block the whole test application, so time budgets can be given:
+ - to each unit test, with the option \c --timeout=T (in seconds), or with the environment variable \c KUT_TIMEOUT,
+ - to the whole run, with the option \c --global-timeout=T, or with the environment variable \c KUT_GLOBAL_TIMEOUT.
+
+A unit test can also set its own budget, counted from its start, with KUT_TEST_TIMEOUT:
+\code
+	KUT_FT_START( foo );
+	KUT_TEST_TIMEOUT( 2.5 );
+	...
+\endcode
+
+Each test records its location when it starts, and checks whether the unit test has been asked to stop (see kut_begin()).
+A unit test over its budget is asked to stop: it stops at its next test, and is recorded as failed,
+with one more failed test at the line of the last test started:
+\verbatim
+ - TIMEOUT: stopped after 2.6 s, time budget: 2.5 s, last test started at line 42 of file test_foo.cpp
+\endverbatim
+If it does not reach a test within KUT_TIMEOUT_GRACE seconds (0.5 by default), what it has written to the log is lost.
+A unit test that ends by itself after its budget is only recorded as failed.
+
+Then:
+ - in fork mode (see \ref forked), the child process sends its results to the test application, or gets killed, and the other unit tests go on,
+ - else, the unit tests are checked by a watchdog thread, started by KUT_MAIN_START. As a thread cannot be killed, the test application ends:
+the other unit tests running are stopped too, the results so far are merged, and the summary is written to the log file, to stdout,
+and to the reporters (see \ref reporters), as by KUT_MAIN_END. The return value is the nb of failures.
+
+When the global budget is exceeded, the unit tests running are stopped the same way, and the unit tests not started yet are not run.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page alloc Allocation tracking
+
+When the test program is built with the symbol \c KUT_TRACK_ALLOC defined (for example <code>-DTESTMODE -DKUT_TRACK_ALLOC</code>),
+KUT_ALLOC also defines the global operator new and delete (plain, array, nothrow and sized forms, and with C++17 the aligned forms), which count,
+for each thread, the allocations, the bytes allocated, and the peak of the memory in use.
+Without it, nothing is replaced, and the macros below run their block without doing any test.
+
+Each unit test then gets a line at its end in the log file:
+\verbatim
+ - Allocations: 12, deallocations: 10, bytes: 4352, peak: 4096 bytes, not freed: 64 bytes
+\endverbatim
+and the final numbers (the test object being destroyed) go to the reporters (see \ref reporters):
+fields \c allocations, \c alloc_bytes, \c alloc_peak and \c alloc_not_freed of the NDJSON records,
+and properties of the same names in the JUnit testsuite.
+
+Two macros turn them into tests, so an allocation regression fails like a wrong value:
+\code
+	KUT_ALLOC_SCOPE_MAX( 1 )      // at most one allocation in the block
+	{
+		std::vector<int> v( 100 );
+	}
+	KUT_NO_LEAK                   // all the memory allocated in the block is freed at its end
+	{
+		foo.Rebuild();
+	}
+\endcode
+On failure, the numbers of the block are written in the log:
+\verbatim
+ * Test 2 (1.2), line: 35: FAIL (1), on line 35 of file test_foo.cpp, expression: no leak
+  -allocations: 3, deallocations: 2, bytes: 96, peak: 96 bytes, not freed: 32 bytes
+\endverbatim
+
+Notes:
+ - the allocations are counted for the thread running the code only: those of the threads started inside a block are not counted,
+ - in verbose mode, the log output of the tests done inside a block also allocates memory, and is counted: for strict limits, do no test inside the block, or disable the verbose mode (see \ref verbose),
+ - leaving the block with \c break skips the test, and an exception going through it skips it too,
+ - the aligned forms of operator new (over-aligned types) are only replaced if the compiler supports them (\c __cpp_aligned_new, C++17).
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//--------------------------------------------------------------------------------------------
+/**
+\page fixtures Fixtures
+
+Objects that are costly to build (large caches, thread pools, memory-mapped indices, ...) can be shared by several unit tests,
+instead of being built by each of them. Such a fixture is obtained in a test with KUT_FIXTURE( type ), that returns a reference:
+\code
+KUT_TEST_FUNCTION( TestLookup )
+{
+	KUT_FT_START( lookup );
+	Index& idx = KUT_FIXTURE( Index );
+	KUT_EQ( idx.Find( "foo" ), 12 );
+	KUT_FT_END;
+}
+\endcode
+
+How the fixture is built, kept and reset is given by specializing KUT_FIXTURE_TRAITS, deriving it from KUT_FIXTURE_BASE
+to keep the default of what is not redefined:
+\code
+template<>
+struct KUT_FIXTURE_TRAITS<Index> : KUT_FIXTURE_BASE<Index>
+{
+	enum { scope = KUT_FIXTURE_SUITE };
+	static Index* Create() { return new Index( "data/words.idx", 4 ); }
+	static void Reset( Index& idx ) { idx.ClearCache(); }
+};
+\endcode
+The scope (see KUT_FIXTURE_SCOPE) is:
+ - \c KUT_FIXTURE_TEST (default): the fixture is built the first time the unit test asks for it, and destroyed when it ends,
+ - \c KUT_FIXTURE_THREAD: one fixture per thread running unit tests (see \ref parallel), built on first use and kept until the thread ends,
+ - \c KUT_FIXTURE_SUITE: one fixture for the whole test program, built on first use and kept until the program ends,
+used by one unit test at a time (see the notes below).
+
+A pooled (thread or suite) fixture is handed over to each unit test in a known state: \c Reset() is called the first time
+a unit test asks for it, except when it has just been built. A unit test asking several times gets the same fixture, without reset.
+The threads started by a unit test (see KUT_THREAD_START) get the fixtures of their unit test
+(a thread fixture being the one of the thread that asked first, ask for it before starting the threads).
+
+The tested classes are built the same way: KUT_TEST_CLASS and KUT_DEF_TEST_METHOD get their object from KUT_FIXTURE_TRAITS, so a class
+without default constructor can be tested by specializing \c Create(), and an object costly to build can be pooled.
+
+Notes:
+ - the suite fixtures are locked by the unit test that asks for one of them, until the unit test ends: with several worker threads, the other
+unit tests asking for a suite fixture wait, so the unit tests using suite fixtures run one at a time (use the thread scope to run them at the same time).
+All the suite fixtures share this lock, so unit tests asking for several of them, in any order, can not deadlock.
+A thread started inside the unit test (see KUT_THREAD_START) can ask for a suite fixture too: the lock belongs to the unit test, not to the thread,
+ - in fork mode (see \ref forked), each child process builds the pooled fixtures it uses, unless they were built before by the test program
+(for example with <code>KUT_FIXTURE( Index );</code> after KUT_MAIN_START, in a hand-written main()), the child processes then getting a copy of them.
+
+<hr>
+\b Navigation
+- \ref index
+- \ref main
+- \ref class_test
+- \ref function_test
+- \ref macros
+- \ref iterative
+- \ref parallel
+- \ref forked
+- \ref bench
+- \ref binlog
+- \ref reporters
+- \ref timings
+- \ref autoreg
+- \ref sharding
+- \ref property
+- \ref fastmode
+- \ref watchdog
+- \ref alloc
+- \ref fixtures
+
+*/
+
+//-------------------------------------------------------------------------------------------
+// this is the "real" beginning of file...
+#ifndef _KUT_H_
+#define _KUT_H_
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <string>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <memory>
+#include <random>
+#include <functional>
+#include <tuple>
+#include <iterator>
+#include <type_traits>
+#include <cstring>
+#include <climits>
+#include <limits>
+#include <new>
+#include <cstddef>
+
+#if defined(__unix__) || defined(__APPLE__)
+	#define KUT_HAS_FORK
+	#include <unistd.h>
+	#include <poll.h>
+	#include <signal.h>
+	#include <sys/wait.h>
+	#include <sys/resource.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <dirent.h>
+	#include <cstring>
+#endif
+
+/// Hardware performance counters, read with perf_event_open() (see \ref perfcount), define KUT_NO_PERFCOUNT to never use them
+#if defined(__linux__) && !defined(KUT_NO_PERFCOUNT)
+	#define KUT_HAS_PERFCOUNT
+	#include <linux/perf_event.h>
+	#include <sys/syscall.h>
+	#include <sys/ioctl.h>
+#endif
+
+/// SIMD instruction sets used by the range comparisons (see KUT_EQ_RANGE), define KUT_NO_SIMD to only use the scalar code
+#if !defined(KUT_NO_SIMD) && ( defined(__SSE2__) || defined(_M_X64) )
+	#define KUT_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+#if !defined(KUT_NO_SIMD) && defined(__AVX2__)
+	#define KUT_SIMD_AVX2
+	#include <immintrin.h>
+#endif
+
+//#include <ios>
+
+
+/// current version of file, printed in logfile
+#define KUT_VERSION "20261016"
+
+//-------------------------------------------------------------------------------------------
+/// \name User interface macros
+//@{
+
+/// epsilon value for testing of equality of floating-point values: default tolerance of KUT_EQ_F (see KUT_TOL)
+#ifndef KUT_EPSILON
+	#define KUT_EPSILON 1e-9
+#endif
+
+/// maximum number of elements of a container written in the log file, when a test fails (see \ref macros)
+#ifndef KUT_PRINT_MAX_ELEMS
+	#define KUT_PRINT_MAX_ELEMS 16
+#endif
+
+/// maximum length of a value written in the log file, when a test fails
+#ifndef KUT_PRINT_MAX_LENGTH
+	#define KUT_PRINT_MAX_LENGTH 256
+#endif
+
+/// maximum number of mismatching elements of two containers written in the log file, when a test fails
+#ifndef KUT_PRINT_MAX_DIFF
+	#define KUT_PRINT_MAX_DIFF 4
+#endif
+
+/// maximum number of mismatching elements written in the log file by KUT_EQ_RANGE and KUT_EQ_RANGE_F
+#ifndef KUT_RANGE_MAX_REPORT
+	#define KUT_RANGE_MAX_REPORT 8
+#endif
+
+/// the logfile name, to be changed if (really ?) needed
+#ifndef KUT_FILENAME
+	#define KUT_FILENAME "kut_logfile.txt"
+#endif
+
+/// time (seconds) given to a unit test that exceeded its time budget to reach its next test, before it is aborted (see \ref watchdog)
+#ifndef KUT_TIMEOUT_GRACE
+	#define KUT_TIMEOUT_GRACE 0.5
+#endif
+
+/// the baseline file name (reference durations of the benchmarks, see \ref bench)
+#ifndef KUT_BASELINE_FILENAME
+	#define KUT_BASELINE_FILENAME "kut_baseline.txt"
+#endif
+
+/// the cache file name (hash of the sources and last result of each unit test, see \ref cache)
+#ifndef KUT_CACHE_FILENAME
+	#define KUT_CACHE_FILENAME "kut_cache.txt"
+#endif
+
+/// defining this to true will enable the 'verbose' mode
+#ifndef KUT_VERBOSE_MODE
+	#define KUT_VERBOSE_MODE true
+#endif
+
+/// Define this (before including kut.h) to build the tests in "fast" mode: the test macros do not log anything
+/// when the test passes, see \ref fastmode
+#ifdef KUT_FAST_MODE
+	#undef  KUT_VERBOSE_MODE
+	#define KUT_VERBOSE_MODE false
+#endif
+
+/// Marks a function as rarely called, so it is compiled out of the hot path
+#if defined(__GNUC__)
+	#define KUT_COLD __attribute__((cold,noinline))
+#elif defined(_MSC_VER)
+	#define KUT_COLD __declspec(noinline)
+#else
+	#define KUT_COLD
+#endif
+
+/// a shorthand logfile
+/**
+This macro also increments the log file line counter, to keep track of where the failure occurs (printed at the end of all tests)
+
+It writes to the log buffer of the current context (see KUT_CONTEXT), that is written to the log file when the unit test ends.
+
+Do not read kut_ctx->line_counter in the same expression (the read and the increment are unsequenced before C++17):
+increment it in a separate statement and write with KUT_LOG2.
+*/
+#define KUT_LOG (kut_ctx->line_counter++, kut_ctx->log)
+
+/// This one does not increment the counter
+#define KUT_LOG2 kut_ctx->log
+
+/// end of line, used in all the log output
+/**
+This does not flush the stream (no \c std::endl), the log file is written by a background thread, see KUT_LOG_SINK
+*/
+#ifndef ENDL
+	#define ENDL '\n'
+#endif
+
+/// size of the log file buffer: when it is full, it is handed to the writer thread (see KUT_LOG_SINK)
+#ifndef KUT_LOG_BUFFER_SIZE
+	#define KUT_LOG_BUFFER_SIZE (1<<20)
+#endif
+
+
+/// User macro, if called with 'true', then a failing test will interrupt current unit-test
+/**
+This is mostly useful when tracking down a bug: instead of letting the whole test suite run each time,
+if you stop immediatly after the failed test, you can right away check the last lines of the log file
+to see your debug output, instead of having to go through (potential) thousands of debug lines.
+
+The failure also stops the run: no other unit test is started, the ones already running (see \ref parallel and \ref forked) end normally,
+and the summary is written, the same way in every mode.
+*/
+#define KUT_STOP_ON_FAIL( a ) \
+	if( a ) \
+	{ \
+		KUT_LOG << " - Switching to mode \"StopTestOnFail\" : ON\n"; \
+		kut_data.StopTestOnFail = true; \
+	} \
+	else \
+	{ \
+		KUT_LOG << " - Switching to mode \"StopTestOnFail\" : OFF\n"; \
+		kut_data.StopTestOnFail = false; \
+	} \
+
+/// User macro, if called with 'true', then KUT_EQ_RANGE and KUT_EQ_RANGE_F scan the whole ranges on failure, to count all the mismatching elements
+/**
+Else (default), they stop once KUT_RANGE_MAX_REPORT mismatching elements have been found.
+*/
+#define KUT_RANGE_COUNT_ALL( a ) \
+	if( a ) \
+	{ \
+		KUT_LOG << " - Switching to mode \"RangeCountAll\" : ON\n"; \
+		kut_data.RangeCountAll = true; \
+	} \
+	else \
+	{ \
+		KUT_LOG << " - Switching to mode \"RangeCountAll\" : OFF\n"; \
+		kut_data.RangeCountAll = false; \
+	} \
+
+/// User macro, sets the time budget of the current unit test to \b s seconds, counted from its start (0 for none)
+/**
+Overrides the default budget given with \c --timeout. See \ref watchdog.
+*/
+#define KUT_TEST_TIMEOUT( s ) \
+	kut_data.watch->budget = (int64_t)( (s) * 1E9 )
+
+//@}
+
+extern bool kut_verbose;
+
+/// true if the tests are recorded in the binary log file (see \ref binlog)
+extern bool kut_binlog;
+
+/// median duration of each benchmark, read from the baseline file (see \ref bench)
+extern std::map<std::string,double> kut_baseline;
+
+//-------------------------------------------------------------------------------------------
+/// Writes the whole buffer \c s to the file descriptor \c fd
+inline void kut_write_fd( int fd, const std::string& s )
+{
+#ifdef KUT_HAS_FORK
+	for( size_t done=0; done<s.size(); )
+	{
+		ssize_t n = write( fd, s.data()+done, s.size()-done );
+		if( n < 0 && errno == EINTR )
+			continue;
+		if( n <= 0 )
+			return;
+		done += n;
+	}
+#endif
+}
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, writes the log file
+/**
+The log output is appended to a large buffer, and the buffers are written to the file by a background thread,
+so writing the log costs almost nothing to the tests. The buffer is handed to the writer thread when it is full,
+at the end of each unit test, and at the end of all tests (KUT_MAIN_END).
+
+If the test application crashes, the signal handler appends the received signal to the file, see kut_crash_handler().
+What was still in memory is lost: the handler can only call async-signal-safe functions.
+*/
+struct KUT_LOG_SINK
+{
+	FILE*                    file;
+	int                      fd;        ///< descriptor of \c file, for the signal handler
+	std::string              buffer;    ///< data not handed yet to the writer thread
+	std::vector<std::string> v_pending; ///< buffers waiting to be written
+	bool                     writing;   ///< true while the writer thread writes some buffers
+	bool                     stop;
+	int                      owner_pid; ///< the writer thread exists only in this process (see \ref forked)
+	std::mutex               mtx;
+	std::condition_variable  cv;        ///< signals new buffers (or stop) to the writer thread
+	std::condition_variable  cv_done;   ///< signals that everything has been written
+	std::thread              writer;
+
+	KUT_LOG_SINK() : file(0), fd(-1), writing(false), stop(false), owner_pid(0)
+	{}
+	~KUT_LOG_SINK()
+	{
+		Close();
+	}
+
+	bool Open( const char* filename )
+	{
+		file = fopen( filename, "wb" );
+		if( !file )
+			return false;
+#ifdef KUT_HAS_FORK
+		owner_pid = getpid();
+		fd = fileno( file );
+#endif
+		buffer.reserve( KUT_LOG_BUFFER_SIZE );
+		writer = std::thread( [this]() { Run(); } );
+		return true;
+	}
+
+/// Appends \c s to the buffer
+	void Write( const std::string& s )
+	{
+		buffer += s;
+		if( buffer.size() >= KUT_LOG_BUFFER_SIZE )
+			Flush();
+	}
+
+/// Hands the buffer to the writer thread (does not wait)
+	void Flush()
+	{
+		if( buffer.empty() || !file )
+			return;
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			v_pending.push_back( std::string() );
+			v_pending.back().swap( buffer );
+		}
+		cv.notify_one();
+		buffer.reserve( KUT_LOG_BUFFER_SIZE );
+	}
+
+/// Hands the buffer to the writer thread, and waits until everything has been written
+	void Sync()
+	{
+		Flush();
+		std::unique_lock<std::mutex> lock( mtx );
+		cv_done.wait( lock, [this]() { return v_pending.empty() && !writing; } );
+	}
+
+/// Writes everything, stops the writer thread, and closes the file
+	void Close()
+	{
+		if( !file || !IsOwner() )
+			return;
+		Sync();
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			stop = true;
+		}
+		cv.notify_one();
+		writer.join();
+		fd = -1;
+		fclose( file );
+		file = 0;
+	}
+
+	bool IsOwner() const
+	{
+#ifdef KUT_HAS_FORK
+		return owner_pid == getpid();
+#else
+		return true;
+#endif
+	}
+
+/// The writer thread
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock( mtx );
+		for(;;)
+		{
+			cv.wait( lock, [this]() { return stop || !v_pending.empty(); } );
+			if( v_pending.empty() )
+				return;
+			std::vector<std::string> v;
+			v.swap( v_pending );
+			writing = true;
+			lock.unlock();
+			for( size_t i=0; i<v.size(); i++ )
+				fwrite( v[i].data(), 1, v[i].size(), file );
+			fflush( file );
+			lock.lock();
+			writing = false;
+			cv_done.notify_all();
+		}
+	}
+};
+
+/// writes the log file
+extern KUT_LOG_SINK kut_logsink;
+
+struct KUT_CONTEXT;
+struct KUT_WATCH;
+
+/// Returns the time budget of the unit test run with the context \c ctx, see KUT_CONTEXT::watch
+inline KUT_WATCH* kut_ctx_watch( KUT_CONTEXT* ctx );
+
+/// the context of the current thread, see KUT_CONTEXT
+extern thread_local KUT_CONTEXT* kut_ctx;
+
+/// the context of the main thread, for everything that is logged outside of the unit tests
+extern KUT_CONTEXT kut_main_context;
+
+/// in a child process (see \ref forked), the pipe to the parent process, -1 otherwise
+extern int kut_fork_fd;
+
+//-------------------------------------------------------------------------------------------
+/// Statistics of a benchmark, all the durations are for one iteration, in seconds
+struct KUT_BENCH_RESULT
+{
+	std::string name;
+	size_t      nb_iter;    ///< total nb of measured iterations
+	size_t      nb_samples; ///< nb of measured samples
+	size_t      batch;      ///< nb of iterations per sample
+	double      min;
+	double      median;
+	double      p99;        ///< 99th percentile
+	double      mean;
+	double      stddev;
+};
+
+/// Hardware performance counters of KUT_PERFCOUNT_START (see \ref perfcount)
+enum KUT_PC
+{
+	KUT_PC_INSTRUCTIONS, KUT_PC_CYCLES, KUT_PC_CACHE_MISSES, KUT_PC_BRANCH_MISSES, KUT_PC_NB
+};
+
+/// Counts of a KUT_PERFCOUNT_START / KUT_PERFCOUNT_END scope, for one call of the measured code
+struct KUT_PERFCOUNT_RESULT
+{
+	std::string name;
+	size_t      nb_calls;           ///< nb of measured calls
+	double      value[KUT_PC_NB];   ///< count per call of each counter (see KUT_PC), negative if not available
+};
+
+//-------------------------------------------------------------------------------------------
+/// Tolerance of the floating-point comparisons (see \ref macros)
+/**
+Two values \c a and \c b are considered as equal if <code>a == b</code>, or if one of these conditions holds:
+ - <code>|a-b| < abs</code>
+ - <code>|a-b| <= rel * max(|a|,|b|)</code>
+ - the distance between \c a and \c b in units in the last place (ULP: number of representable values between them) is at most \c ulp
+
+A null field disables its condition. Tolerances are built with kut_abs(), kut_rel() and kut_ulp(), and combined with the | operator:
+\code
+	KUT_EQ_TOL( x, y, kut_rel( 1E-6 ) | kut_ulp( 4 ) );
+\endcode
+*/
+struct KUT_TOL
+{
+	double   abs;
+	double   rel;
+	uint64_t ulp;
+
+	explicit KUT_TOL( double a = 0., double r = 0., uint64_t u = 0 )
+		: abs( a ), rel( r ), ulp( u )
+	{}
+};
+
+/// Absolute tolerance, see KUT_TOL
+inline KUT_TOL kut_abs( double v )
+{
+	return KUT_TOL( v );
+}
+
+/// Relative tolerance, see KUT_TOL
+inline KUT_TOL kut_rel( double v )
+{
+	return KUT_TOL( 0., v );
+}
+
+/// Tolerance in units in the last place, see KUT_TOL
+inline KUT_TOL kut_ulp( uint64_t v )
+{
+	return KUT_TOL( 0., 0., v );
+}
+
+/// Combines two tolerances: the values are equal if a condition of one of them holds
+inline KUT_TOL operator | ( const KUT_TOL& t1, const KUT_TOL& t2 )
+{
+	return KUT_TOL( std::max( t1.abs, t2.abs ), std::max( t1.rel, t2.rel ), std::max( t1.ulp, t2.ulp ) );
+}
+
+inline std::ostream& operator << ( std::ostream& f, const KUT_TOL& t )
+{
+	const char* sep = "";
+	if( t.abs )
+	{
+		f << "abs " << t.abs;
+		sep = " | ";
+	}
+	if( t.rel )
+	{
+		f << sep << "rel " << t.rel;
+		sep = " | ";
+	}
+	if( t.ulp )
+		f << sep << "ulp " << t.ulp;
+	else if( !*sep )
+		f << "none";
+	return f;
+}
+
+/// Largest errors measured by a floating-point comparison, over all its calls in a unit test (see KUT_CONTEXT::PrintFpStats())
+struct KUT_FP_STAT
+{
+	const char* file;
+	int         line;
+	size_t      nb;      ///< nb of compared values
+	double      max_abs;
+	double      max_rel;
+	uint64_t    max_ulp;
+	bool        has_ulp; ///< false if the ULP distances are not measured (range macros)
+	KUT_TOL     tol;     ///< last tolerance used
+};
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, holds several counters related to the current unit-test.
+struct KUT_TYPE
+{
+	int  count_fail; ///< Nb of tests that failed.
+	int  count_test; ///< Total nb of tests
+	int  count_test1; ///< major text counter
+	int  count_test2; ///< minor text counter
+	bool StopTestOnFail;
+	bool RangeCountAll; ///< see KUT_RANGE_COUNT_ALL
+	bool DoQuit;
+	bool kut_failflag; ///< used to communicate failure between different parts of macros
+	KUT_CONTEXT* ctx;  ///< context of the thread running the test, see KUT_THREAD_START
+	KUT_WATCH*   watch; ///< time budget of the unit test, from \c ctx (see \ref watchdog)
+	KUT_TOL tol;       ///< tolerance of KUT_EQ_F, see KUT_TOL_SCOPE
+	std::vector<KUT_BENCH_RESULT> v_bench; ///< results of the benchmarks run by the test, see KUT_BENCH_START
+	std::vector<KUT_PERFCOUNT_RESULT> v_perfcount; ///< results of the counter scopes run by the test, see KUT_PERFCOUNT_START
+
+//-------------------------------------------------------------------------------------------
+/// Constructor, initialises all the fields
+	KUT_TYPE()
+	{
+		count_fail  = 0;
+		count_test1 = 0;
+		count_test2 = 0;
+		count_test  = 0;
+		StopTestOnFail = false;
+		RangeCountAll = false;
+		DoQuit = false;
+		kut_failflag = false;
+		ctx = kut_ctx;
+		watch = kut_ctx_watch( ctx );
+		tol = KUT_TOL( KUT_EPSILON );
+	}
+};
+
+/// Sets the tolerance of KUT_EQ_F until the end of the scope, see KUT_TOL_SCOPE
+struct KUT_TOL_GUARD
+{
+	KUT_TYPE& data;
+	KUT_TOL   prev;
+
+	KUT_TOL_GUARD( KUT_TYPE& d, const KUT_TOL& t ) : data( d ), prev( d.tol )
+	{
+		d.tol = t;
+	}
+	~KUT_TOL_GUARD()
+	{
+		data.tol = prev;
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Prints a duration (in seconds) with an adapted unit
+inline std::string kut_format_duration( double t )
+{
+	std::ostringstream oss;
+	if( t < 1e-6 )
+		oss << t*1e9 << " ns";
+	else if( t < 1e-3 )
+		oss << t*1e6 << " us";
+	else if( t < 1. )
+		oss << t*1e3 << " ms";
+	else
+		oss << t << " s";
+	return oss.str();
+}
+
+/// Heap allocations done by a thread, counted by the operator new/delete of KUT_ALLOC if KUT_TRACK_ALLOC is defined (see \ref alloc)
+struct KUT_ALLOC_COUNT
+{
+	int64_t nb_alloc; ///< nb of allocations
+	int64_t nb_free;  ///< nb of deallocations
+	int64_t bytes;    ///< bytes allocated
+	int64_t cur;      ///< bytes allocated minus bytes freed by this thread
+	int64_t peak;     ///< maximum of \c cur, reset by KUT_ALLOC_MARK
+};
+
+/// the allocations of the current thread
+extern thread_local KUT_ALLOC_COUNT kut_alloc_count;
+
+/// true if the operator new/delete of KUT_ALLOC count the allocations (KUT_TRACK_ALLOC defined)
+extern bool kut_alloc_hooked;
+
+/// Size of the header stored before each block allocated by kut_alloc(), holding its size. Keeps the alignment of malloc()
+#define KUT_ALLOC_HEADER alignof( std::max_align_t )
+
+/// Counts an allocation of \c n bytes
+inline void kut_count_alloc( size_t n )
+{
+	KUT_ALLOC_COUNT& c = kut_alloc_count;
+	c.nb_alloc++;
+	c.bytes += n;
+	c.cur   += n;
+	if( c.cur > c.peak )
+		c.peak = c.cur;
+}
+
+/// Counts a deallocation of \c n bytes
+inline void kut_count_free( size_t n )
+{
+	KUT_ALLOC_COUNT& c = kut_alloc_count;
+	c.nb_free++;
+	c.cur -= n;
+}
+
+/// Allocates \c n bytes, and counts them (called by the operator new of KUT_ALLOC), returns null on failure
+inline void* kut_alloc( size_t n )
+{
+	if( n > SIZE_MAX - KUT_ALLOC_HEADER )
+		return 0;
+	char* p = (char*)malloc( n + KUT_ALLOC_HEADER );
+	if( !p )
+		return 0;
+	*(size_t*)p = n;
+	kut_count_alloc( n );
+	return p + KUT_ALLOC_HEADER;
+}
+
+/// Frees a block allocated by kut_alloc() (called by the operator delete of KUT_ALLOC)
+inline void kut_free( void* p )
+{
+	if( !p )
+		return;
+	char* b = (char*)p - KUT_ALLOC_HEADER;
+	kut_count_free( *(size_t*)b );
+	free( b );
+}
+
+/// Allocates \c n bytes aligned on \c align (a power of 2), and counts them (called by the aligned operator new of KUT_ALLOC), returns null on failure
+/**
+The size of the block and the address returned by malloc() are stored right before the block.
+*/
+inline void* kut_alloc_aligned( size_t n, size_t align )
+{
+	const size_t head = 2*sizeof(size_t);
+	if( align - 1 > SIZE_MAX - head || n > SIZE_MAX - head - ( align - 1 ) )
+		return 0;
+	char* b = (char*)malloc( n + head + align - 1 );
+	if( !b )
+		return 0;
+	uintptr_t u = ( (uintptr_t)b + head + align - 1 ) & ~(uintptr_t)( align - 1 );
+	size_t* p = (size_t*)u;
+	p[-1] = (size_t)(uintptr_t)b;
+	p[-2] = n;
+	kut_count_alloc( n );
+	return p;
+}
+
+/// Frees a block allocated by kut_alloc_aligned() (called by the aligned operator delete of KUT_ALLOC)
+inline void kut_free_aligned( void* p )
+{
+	if( !p )
+		return;
+	size_t* h = (size_t*)p;
+	kut_count_free( h[-2] );
+	free( (void*)(uintptr_t)h[-1] );
+}
+
+/// Allocations done between its creation and the call to Stop(), the peak being measured over this interval only. Can be nested
+struct KUT_ALLOC_MARK
+{
+	KUT_ALLOC_COUNT start;
+	int64_t         prev_peak; ///< peak before the creation, restored by Stop()
+
+	KUT_ALLOC_MARK()
+	{
+		start = kut_alloc_count;
+		prev_peak = kut_alloc_count.peak;
+		kut_alloc_count.peak = kut_alloc_count.cur;
+	}
+/// Returns the allocations done since the creation: \c cur is the nb of bytes not freed, \c peak is relative to the start
+	KUT_ALLOC_COUNT Peek() const
+	{
+		const KUT_ALLOC_COUNT& c = kut_alloc_count;
+		KUT_ALLOC_COUNT d;
+		d.nb_alloc = c.nb_alloc - start.nb_alloc;
+		d.nb_free  = c.nb_free  - start.nb_free;
+		d.bytes    = c.bytes    - start.bytes;
+		d.cur      = c.cur      - start.cur;
+		d.peak     = c.peak     - start.cur;
+		return d;
+	}
+/// Same as Peek(), and restores the peak of the enclosing interval
+	KUT_ALLOC_COUNT Stop()
+	{
+		KUT_ALLOC_COUNT d = Peek();
+		kut_alloc_count.peak = std::max( kut_alloc_count.peak, prev_peak );
+		return d;
+	}
+};
+
+/// Resources used by a unit test, or by a function called with KUT_EXECFUNC (see \ref timings)
+struct KUT_TIMING
+{
+	std::string name;  ///< name of class/function tested, "unit test/function" for KUT_EXECFUNC
+	int         type;  ///< 0 for a class, 1 for a function, 2 for a function called with KUT_EXECFUNC
+	double      wall;  ///< wall clock time, in seconds
+	double      user;  ///< user CPU time, in seconds
+	double      sys;   ///< system CPU time, in seconds
+	long        rss;   ///< increase of the peak resident set size, in kB
+	KUT_ALLOC_COUNT alloc; ///< heap allocations, if counted (see \ref alloc)
+
+	KUT_TIMING() : type(0), wall(0.), user(0.), sys(0.), rss(0), alloc()
+	{}
+};
+
+/// Gets the CPU times used so far by the current thread (by the process if not available), and the peak RSS of the process
+inline void kut_rusage( double& user, double& sys, long& rss )
+{
+#ifdef KUT_HAS_FORK
+	rusage ru;
+	#ifdef RUSAGE_THREAD
+		getrusage( RUSAGE_THREAD, &ru );
+	#else
+		getrusage( RUSAGE_SELF, &ru );
+	#endif
+	user = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1E-6;
+	sys  = ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1E-6;
+	rusage ru_self;
+	getrusage( RUSAGE_SELF, &ru_self );
+	#ifdef __APPLE__
+		rss = ru_self.ru_maxrss / 1024;   // in bytes on macOS
+	#else
+		rss = ru_self.ru_maxrss;
+	#endif
+#else
+	user = (double)std::clock() / CLOCKS_PER_SEC;
+	sys  = 0.;
+	rss  = 0;
+#endif
+}
+
+/// Measures the resources used between its creation and the call to Stop()
+struct KUT_TIMER
+{
+	std::chrono::steady_clock::time_point start;
+	double user, sys;
+	long   rss;
+	KUT_ALLOC_MARK alloc;
+
+	KUT_TIMER()
+	{
+		kut_rusage( user, sys, rss );
+		start = std::chrono::steady_clock::now();
+	}
+	KUT_TIMING Stop( const std::string& name, int type )
+	{
+		KUT_TIMING t;
+		t.alloc = alloc.Stop();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		kut_rusage( t.user, t.sys, t.rss );
+		t.name  = name;
+		t.type  = type;
+		t.wall  = elapsed.count();
+		t.user -= user;
+		t.sys  -= sys;
+		t.rss  -= rss;
+		return t;
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Operators of the tests, as stored in the binary log file (see \ref binlog)
+enum KUT_OP
+{
+	KUT_OP_EQ, KUT_OP_DIFF, KUT_OP_LESS, KUT_OP_TRUE, KUT_OP_FALSE, KUT_OP_EQ_F,
+	KUT_OP_NOTHROW, KUT_OP_THROW, KUT_OP_LOOP, KUT_OP_PERF, KUT_OP_PROPERTY,
+	KUT_OP_EQ_RANGE, KUT_OP_EQ_RANGE_F, KUT_OP_ALLOC, KUT_OP_PERFCOUNT,
+	KUT_OP_NB
+};
+
+/// Name of a KUT_OP value
+inline const char* kut_op_name( int op )
+{
+	static const char* names[] = { "EQ", "DIFF", "LESS", "TRUE", "FALSE", "EQ_F", "NOTHROW", "THROW", "LOOP", "PERF", "PROPERTY", "EQ_RANGE", "EQ_RANGE_F", "ALLOC", "PERFCOUNT" };
+	return op >= 0 && op < KUT_OP_NB ? names[op] : "?";
+}
+
+/// Chunk types of the binary log file
+enum
+{
+	KUT_BIN_STRING = 1, ///< followed by: uint32 string id, uint32 length, characters
+	KUT_BIN_UNIT_TEST,  ///< followed by: uint32 unit test id, uint32 name id, uint32 type (0: class, 1: function), int32 nb of tests, int32 nb of failures
+	KUT_BIN_RECORDS     ///< followed by: uint32 nb of records, records (KUT_BIN_RECORD)
+};
+
+/// first bytes of the binary log file, followed by the size of KUT_BIN_RECORD (uint32)
+#define KUT_BIN_MAGIC "KUTBIN1"
+
+/// One record of the binary log file, for each test done (see \ref binlog)
+struct KUT_BIN_RECORD
+{
+	uint32_t test_id;   ///< nb of the unit test (1 for the first one)
+	uint32_t file_id;   ///< file name, id in the string table
+	uint32_t expr_id;   ///< expression tested, id in the string table
+	uint32_t line;
+	uint32_t index;     ///< nb of the test inside its unit test
+	uint8_t  op;        ///< see KUT_OP
+	uint8_t  pass;      ///< 1 if the test passed, 0 if it failed
+	uint16_t reserved;
+	uint64_t timestamp; ///< in ns, since the beginning of the run
+};
+
+/// A test, as recorded during the unit test. The strings get their id only when the unit test is merged (see KUT_MASTER::WriteBinLog())
+struct KUT_TEST_RECORD
+{
+	const char*  file;
+	const char*  expr;
+	unsigned int line;
+	int          index;
+	int          op;
+	bool         pass;
+	int64_t      timestamp; ///< steady clock, in ns
+};
+
+/// Adds a record of the test that has just been done to the binary log, if enabled (see \ref binlog)
+#define KUT_P_RECORD( op, expr ) \
+	if( kut_binlog ) \
+		kut_ctx->AddRecord( __FILE__, __LINE__, expr, op, !kut_data.kut_failflag, kut_data.count_test )
+
+struct KUT_SITE;
+
+//-------------------------------------------------------------------------------------------
+/// Steady clock, in ns
+inline int64_t kut_steady_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//-------------------------------------------------------------------------------------------
+/// Time budget and progress of a running unit test, checked by the watchdog (see \ref watchdog)
+/**
+Written by the thread running the test, read by the watchdog thread, or by the parent process in fork mode (the structure is then in shared memory).
+*/
+struct KUT_WATCH
+{
+	std::atomic<int64_t>     start;  ///< steady clock at the start of the unit test, in ns
+	std::atomic<int64_t>     budget; ///< time budget of the unit test, in ns, 0 for none (see KUT_TEST_TIMEOUT)
+	std::atomic<int>         line;   ///< line of the last test started, see kut_begin()
+	std::atomic<const char*> file;   ///< file of the last test started, null if none
+	std::atomic<int>         state;  ///< 0: running, 1: stop requested by the watchdog, 2: stopped in kut_watch_expired()
+	const KUT_TYPE*          data;   ///< counters of the stopped unit test, valid once \c state is 2
+	int64_t                  stop;   ///< steady clock when it stopped, in ns, 0 if still running
+
+	KUT_WATCH()
+	{
+		Start( 0. );
+	}
+
+/// Called when the unit test starts, with its default budget (seconds)
+	void Start( double budget_s )
+	{
+		start  = kut_steady_ns();
+		budget = (int64_t)( budget_s * 1E9 );
+		line   = 0;
+		file   = 0;
+		state  = 0;
+		data   = 0;
+		stop   = 0;
+	}
+
+/// Returns true if the budget is exceeded at time \c now
+	bool Exceeded( int64_t now ) const
+	{
+		int64_t b = budget.load( std::memory_order_relaxed );
+		return b > 0 && now - start.load( std::memory_order_relaxed ) > b;
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, the lock of the suite fixtures (see KUT_FIXTURE)
+/**
+It is taken by a unit test when it first asks for a suite fixture, and released when the unit test ends, maybe from another thread
+(see KUT_CONTEXT::ReleaseFixtures()). So it is a flag guarded by a condition variable, not a mutex held during the whole unit test.
+*/
+struct KUT_SUITE_LOCK
+{
+	std::mutex              mtx;
+	std::condition_variable cv;
+	bool                    taken;
+
+	KUT_SUITE_LOCK() : taken(false)
+	{}
+
+/// Waits until no other unit test holds the lock, and takes it
+	void Take()
+	{
+		std::unique_lock<std::mutex> lock( mtx );
+		cv.wait( lock, [this]() { return !taken; } );
+		taken = true;
+	}
+
+	void Release()
+	{
+		{
+			std::lock_guard<std::mutex> lock( mtx );
+			taken = false;
+		}
+		cv.notify_one();
+	}
+};
+
+/// Returns the lock shared by all the suite fixtures
+inline KUT_SUITE_LOCK& kut_suite_lock()
+{
+	static KUT_SUITE_LOCK lock;
+	return lock;
+}
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, holds the state of a unit test that is private to the thread running it.
+/**
+Every unit test is run with its own context (see KUT_MASTER::RunTest()), and the test macros only access the context
+of the current thread, through the thread-local pointer \c kut_ctx. So no lock is needed, and tests can be run concurrently.
+
+The log output is kept in a buffer, and is written as a whole to the log file when the unit test ends,
+so the output of tests run in parallel never gets mixed.
+
+Additional threads started inside a unit test have their own context too, see KUT_THREAD_START.
+*/
+struct KUT_CONTEXT
+{
+	std::vector<std::string>  fail_file;    ///< file of each failed test
+	std::vector<unsigned int> fail_line;    ///< line of each failed test
+	size_t                    line_counter; ///< log file line counter, see KUT_LOG
+	bool                      line_known;   ///< false if \c line_counter does not start at the current line of the log file (worker thread, child process, thread started by the unit test)
+	std::ostringstream        log;          ///< log output, not written yet to the log file
+	std::vector<KUT_TEST_RECORD> v_record;  ///< tests done, for the binary log file (see \ref binlog)
+	std::vector<KUT_TIMING>   v_timing;     ///< functions called with KUT_EXECFUNC
+	std::map<const KUT_SITE*,KUT_FP_STAT> m_fp_stat; ///< floating-point comparisons (verbose mode only), see PrintFpStats()
+	KUT_WATCH   own_watch;
+	KUT_WATCH*  watch;             ///< time budget of the unit test, \c own_watch, or shared with the parent process in fork mode
+	const KUT_ALLOC_MARK* alloc;   ///< allocations of the unit test, see PrintAllocStats()
+	KUT_CONTEXT* owner;            ///< context of the unit test: this one, or the one of the unit test for a thread started inside it
+	std::recursive_mutex fixture_mutex; ///< protects \c v_fixture, recursive as building a fixture can ask for another one
+	std::vector<std::pair<const void*,std::shared_ptr<void>>> v_fixture; ///< fixtures handed to the unit test, see kut_fixture()
+	bool        suite_locked;      ///< true if the unit test holds the lock of the suite fixtures, see kut_suite_lock()
+
+	std::mutex  thread_mutex;      ///< protects the results of the threads (fields below)
+	int         thread_count_test; ///< nb of tests done by the threads started inside the unit test
+	int         thread_count_fail; ///< nb of failures of these threads
+	std::vector<std::string>  thread_fail_file;
+	std::vector<unsigned int> thread_fail_line;
+	std::string thread_log;        ///< log output of these threads
+	size_t      thread_nb_loglines;
+	std::vector<KUT_TEST_RECORD> thread_record;
+	bool        thread_do_quit;    ///< true if a thread failed in "StopTestOnFail" mode, see kut_premature_end()
+
+	explicit KUT_CONTEXT( size_t line_base = 0, bool known = false )
+	{
+		line_counter       = line_base;
+		line_known         = known;
+		thread_count_test  = 0;
+		thread_count_fail  = 0;
+		thread_nb_loglines = 0;
+		thread_do_quit     = false;
+		watch              = &own_watch;
+		alloc              = 0;
+		owner              = this;
+		suite_locked       = false;
+	}
+	~KUT_CONTEXT()
+	{
+		ReleaseFixtures();
+	}
+
+/// Destroys the fixtures of the unit test, and releases the lock of the suite fixtures (called when the unit test ends, see KUT_MASTER::RunTest())
+	void ReleaseFixtures()
+	{
+		std::lock_guard<std::recursive_mutex> lock( fixture_mutex );
+		v_fixture.clear();
+		if( suite_locked )
+			kut_suite_lock().Release();
+		suite_locked = false;
+	}
+
+	KUT_FP_STAT* FpStat( const KUT_SITE* site, const KUT_TOL& tol, bool has_ulp );
+
+/// Writes the largest errors of the floating-point comparisons in the log, and clears them (called at the end of a unit test)
+	void PrintFpStats()
+	{
+		if( m_fp_stat.empty() )
+			return;
+		std::vector<KUT_FP_STAT> v;
+		for( std::map<const KUT_SITE*,KUT_FP_STAT>::const_iterator it=m_fp_stat.begin(); it!=m_fp_stat.end(); ++it )
+			v.push_back( it->second );
+		std::sort( v.begin(), v.end(), []( const KUT_FP_STAT& s1, const KUT_FP_STAT& s2 )
+			{ return std::strcmp( s1.file, s2.file ) < 0 || ( std::strcmp( s1.file, s2.file ) == 0 && s1.line < s2.line ); } );
+		line_counter++;
+		log << " - Largest errors of the floating-point comparisons:" << ENDL;
+		for( size_t i=0; i<v.size(); i++ )
+		{
+			line_counter++;
+			log << "   - line " << v[i].line << " of file " << v[i].file << ": " << v[i].nb << " values, abs: " << v[i].max_abs
+				<< ", rel: " << v[i].max_rel;
+			if( v[i].has_ulp )
+				log << ", ulp: " << v[i].max_ulp;
+			log << ", tolerance: " << v[i].tol << ENDL;
+		}
+		m_fp_stat.clear();
+	}
+
+/// Writes the allocations done so far by the unit test in the log, if they are counted (see \ref alloc)
+	void PrintAllocStats()
+	{
+		if( !kut_alloc_hooked || !alloc )
+			return;
+		KUT_ALLOC_COUNT a = alloc->Peek();
+		line_counter++;
+		log << " - Allocations: " << a.nb_alloc << ", deallocations: " << a.nb_free << ", bytes: " << a.bytes
+			<< ", peak: " << a.peak << " bytes, not freed: " << a.cur << " bytes" << ENDL;
+	}
+
+/// Returns the " TEMP n" reference to the current line of the log file, empty if not known (see \c line_known)
+	std::string LineRef() const
+	{
+		if( !line_known )
+			return std::string();
+		std::ostringstream oss;
+		oss << " TEMP " << line_counter;
+		return oss.str();
+	}
+
+/// Writes the log buffer to the log file, and clears it
+	void Flush( KUT_LOG_SINK& f )
+	{
+		f.Write( log.str() );
+		log.str( "" );
+	}
+
+/// Records a test, for the binary log file
+	void AddRecord( const char* file, unsigned int line, const char* expr, int op, bool pass, int index )
+	{
+		KUT_TEST_RECORD r;
+		r.file  = file;
+		r.expr  = expr;
+		r.line  = line;
+		r.index = index;
+		r.op    = op;
+		r.pass  = pass;
+		r.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+		v_record.push_back( r );
+	}
+
+/// Called by a thread started inside the unit test, when it ends (see KUT_THREAD_END)
+	void AddThreadResults( KUT_CONTEXT& thread_ctx, const KUT_TYPE& thread_data )
+	{
+		std::lock_guard<std::mutex> lock( thread_mutex );
+		thread_count_test += thread_data.count_test;
+		thread_count_fail += thread_data.count_fail;
+		thread_fail_file.insert( thread_fail_file.end(), thread_ctx.fail_file.begin(), thread_ctx.fail_file.end() );
+		thread_fail_line.insert( thread_fail_line.end(), thread_ctx.fail_line.begin(), thread_ctx.fail_line.end() );
+		thread_log         += thread_ctx.log.str();
+		thread_nb_loglines += thread_ctx.line_counter;
+		thread_record.insert( thread_record.end(), thread_ctx.v_record.begin(), thread_ctx.v_record.end() );
+		thread_do_quit     = thread_do_quit || thread_data.DoQuit;
+	}
+
+/// Adds the results of the threads that have ended to the results of the unit test (see KUT_CTM_END, KUT_FT_END)
+	void MergeThreadResults( KUT_TYPE& kut_data )
+	{
+		std::lock_guard<std::mutex> lock( thread_mutex );
+		kut_data.count_test += thread_count_test;
+		kut_data.count_fail += thread_count_fail;
+		fail_file.insert( fail_file.end(), thread_fail_file.begin(), thread_fail_file.end() );
+		fail_line.insert( fail_line.end(), thread_fail_line.begin(), thread_fail_line.end() );
+		log << thread_log;
+		line_counter += thread_nb_loglines;
+		v_record.insert( v_record.end(), thread_record.begin(), thread_record.end() );
+		kut_data.DoQuit = kut_data.DoQuit || thread_do_quit;
+		thread_record.clear();
+		thread_count_test = thread_count_fail = 0;
+		thread_fail_file.clear();
+		thread_fail_line.clear();
+		thread_log.clear();
+		thread_nb_loglines = 0;
+	}
+};
+
+inline KUT_WATCH* kut_ctx_watch( KUT_CONTEXT* ctx )
+{
+	return ctx->watch;
+}
+
+//-------------------------------------------------------------------------------------------
+/// Stream buffer of kut_logfile: appends the characters to the log of the current unit test (see KUT_CONTEXT::log)
+struct KUT_LOG_STREAMBUF : public std::streambuf
+{
+protected:
+	int_type overflow( int_type c )
+	{
+		if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+			kut_ctx->log.put( traits_type::to_char_type( c ) );
+		return traits_type::not_eof( c );
+	}
+	std::streamsize xsputn( const char* s, std::streamsize n )
+	{
+		kut_ctx->log.write( s, n );
+		return n;
+	}
+};
+
+/// Type of kut_logfile, the log file as an output stream
+/**
+Up to release 20120518, kut_logfile was a std::ofstream. The log file is now written by kut_logsink,
+and what is written to kut_logfile goes to the log of the current unit test, as with KUT_LOG2.
+*/
+struct KUT_LOG_STREAM : public std::ostream
+{
+	KUT_LOG_STREAMBUF sb;
+
+	KUT_LOG_STREAM() : std::ostream( 0 )
+	{
+		rdbuf( &sb );
+	}
+	bool is_open() const
+	{
+		return kut_logsink.file != 0;
+	}
+};
+
+/// the log file, as an output stream
+extern KUT_LOG_STREAM kut_logfile;
+
+//-------------------------------------------------------------------------------------------
+/// Signature of the functions running a unit test, see KUT_TEST_CLASS and KUT_TEST_FUNC
+typedef KUT_TYPE (*KUT_UT_FUNC)();
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, holds a unit test, and its results once it has been run
+struct KUT_UNIT_TEST
+{
+	std::string name;        ///< name of class/function tested
+	int         type;        ///< 0 for a class, 1 for a function
+	KUT_UT_FUNC func;        ///< function running the test
+	KUT_TYPE    result;      ///< counters returned by the test
+	std::string log;         ///< log output of the test
+	size_t      nb_loglines; ///< nb of lines in \c log, see KUT_CONTEXT::line_counter
+	std::vector<std::string>  fail_file; ///< file of each failed test
+	std::vector<unsigned int> fail_line; ///< line of each failed test
+	std::vector<KUT_TEST_RECORD> v_record; ///< tests done, for the binary log file (see \ref binlog)
+	KUT_TIMING  timing;      ///< resources used by the test
+	std::vector<KUT_TIMING> v_timing; ///< resources used by the functions called with KUT_EXECFUNC
+	bool        ended;       ///< true once run, see KUT_MASTER::Unwatch()
+	const char* file;        ///< source file defining the test, known for the registered unit tests only (see \ref cache)
+	uint64_t    hash;        ///< hash of \c file and of its dependencies, 0 if not computed
+
+	KUT_UNIT_TEST( const char* n, int t, KUT_UT_FUNC f ) : name(n), type(t), func(f), nb_loglines(0), ended(false), file(0), hash(0)
+	{
+		timing.name = n;
+		timing.type = t;
+	}
+
+/// Copies the results of the test, held by \c kut_data and by the context \c ctx, whose line counter started at \c line_base
+	void SetResult( const KUT_TYPE& kut_data, KUT_CONTEXT& ctx, size_t line_base )
+	{
+		result      = kut_data;
+		log         = ctx.log.str();
+		nb_loglines = ctx.line_counter - line_base;
+		fail_file   = ctx.fail_file;
+		fail_line   = ctx.fail_line;
+		v_record.swap( ctx.v_record );
+		v_timing.swap( ctx.v_timing );
+	}
+
+/// Records that the unit test exceeded its time budget, as one more failed test at the line of the last test started (see \ref watchdog)
+	void AddTimeout( const KUT_WATCH& w )
+	{
+		double elapsed = ( ( w.stop ? w.stop : kut_steady_ns() ) - w.start.load() ) * 1E-9;
+		const char* file = w.file.load();
+		std::ostringstream oss;
+		oss << " - TIMEOUT: stopped after " << kut_format_duration( elapsed );
+		if( w.budget.load() > 0 )
+			oss << ", time budget: " << kut_format_duration( w.budget.load() * 1E-9 );
+		if( file )
+			oss << ", last test started at line " << w.line.load() << " of file " << file;
+		else
+			oss << ", no test started";
+		oss << '\n';
+		log += oss.str();
+		nb_loglines++;
+		result.count_test++;
+		result.count_fail++;
+		fail_file.push_back( file ? file : name );
+		fail_line.push_back( file ? w.line.load() : 0 );
+	}
+
+/// Serializes the results, so a child process can send them to its parent (see \ref forked)
+	std::string Encode() const
+	{
+		std::ostringstream oss;
+		oss << result.count_test << ' ' << result.count_fail << ' ' << result.count_test1 << ' ' << result.count_test2 << ' '
+			<< result.DoQuit << ' ' << nb_loglines << ' ' << fail_line.size() << ' ';
+		for( size_t i=0; i<fail_line.size(); i++ )
+			oss << fail_line[i] << ' ' << fail_file[i].size() << ' ' << fail_file[i];
+		oss << log.size() << ' ' << log << result.v_bench.size() << ' ';
+		oss.precision( 17 );
+		for( size_t i=0; i<result.v_bench.size(); i++ )
+		{
+			const KUT_BENCH_RESULT& b = result.v_bench[i];
+			oss << b.name.size() << ' ' << b.name << b.nb_iter << ' ' << b.nb_samples << ' ' << b.batch << ' '
+				<< b.min << ' ' << b.median << ' ' << b.p99 << ' ' << b.mean << ' ' << b.stddev << ' ';
+		}
+		oss << result.v_perfcount.size() << ' ';
+		for( size_t i=0; i<result.v_perfcount.size(); i++ )
+		{
+			const KUT_PERFCOUNT_RESULT& pc = result.v_perfcount[i];
+			oss << pc.name.size() << ' ' << pc.name << pc.nb_calls << ' ';
+			for( int j=0; j<KUT_PC_NB; j++ )
+				oss << pc.value[j] << ' ';
+		}
+// the strings of the records are literals: after fork(), they have the same address in the parent process
+		oss << v_record.size() << ' ';
+		for( size_t i=0; i<v_record.size(); i++ )
+		{
+			const KUT_TEST_RECORD& r = v_record[i];
+			oss << (uintptr_t)r.file << ' ' << (uintptr_t)r.expr << ' ' << r.line << ' ' << r.index << ' '
+				<< r.op << ' ' << r.pass << ' ' << r.timestamp << ' ';
+		}
+		const KUT_ALLOC_COUNT& a = timing.alloc;
+		oss << timing.wall << ' ' << timing.user << ' ' << timing.sys << ' ' << timing.rss << ' '
+			<< a.nb_alloc << ' ' << a.nb_free << ' ' << a.bytes << ' ' << a.cur << ' ' << a.peak << ' ' << v_timing.size() << ' ';
+		for( size_t i=0; i<v_timing.size(); i++ )
+		{
+			const KUT_TIMING& t = v_timing[i];
+			oss << t.name.size() << ' ' << t.name << t.wall << ' ' << t.user << ' ' << t.sys << ' ' << t.rss << ' ';
+		}
+		return oss.str();
+	}
+
+/// Reads the results serialized by Encode(), returns false if they are incomplete
+	bool Decode( const std::string& s )
+	{
+		std::istringstream iss( s );
+		size_t nb_fail = 0, len = 0;
+		iss >> result.count_test >> result.count_fail >> result.count_test1 >> result.count_test2
+			>> result.DoQuit >> nb_loglines >> nb_fail;
+		for( size_t i=0; i<nb_fail && iss; i++ )
+		{
+			unsigned int line = 0;
+			iss >> line >> len;
+			iss.get();
+			std::string file( len, ' ' );
+			iss.read( &file[0], len );
+			fail_line.push_back( line );
+			fail_file.push_back( file );
+		}
+		iss >> len;
+		iss.get();
+		log.assign( len, ' ' );
+		iss.read( &log[0], len );
+		size_t nb_bench = 0;
+		iss >> nb_bench;
+		result.v_bench.resize( nb_bench );
+		for( size_t i=0; i<nb_bench && iss; i++ )
+		{
+			KUT_BENCH_RESULT& b = result.v_bench[i];
+			iss >> len;
+			iss.get();
+			b.name.assign( len, ' ' );
+			iss.read( &b.name[0], len );
+			iss >> b.nb_iter >> b.nb_samples >> b.batch >> b.min >> b.median >> b.p99 >> b.mean >> b.stddev;
+		}
+		size_t nb_perfcount = 0;
+		iss >> nb_perfcount;
+		result.v_perfcount.resize( nb_perfcount );
+		for( size_t i=0; i<nb_perfcount && iss; i++ )
+		{
+			KUT_PERFCOUNT_RESULT& pc = result.v_perfcount[i];
+			iss >> len;
+			iss.get();
+			pc.name.assign( len, ' ' );
+			iss.read( &pc.name[0], len );
+			iss >> pc.nb_calls;
+			for( int j=0; j<KUT_PC_NB; j++ )
+				iss >> pc.value[j];
+		}
+		size_t nb_record = 0;
+		iss >> nb_record;
+		v_record.resize( nb_record );
+		for( size_t i=0; i<nb_record && iss; i++ )
+		{
+			KUT_TEST_RECORD& r = v_record[i];
+			uintptr_t file = 0, expr = 0;
+			iss >> file >> expr >> r.line >> r.index >> r.op >> r.pass >> r.timestamp;
+			r.file = (const char*)file;
+			r.expr = (const char*)expr;
+		}
+		size_t nb_timing = 0;
+		KUT_ALLOC_COUNT& a = timing.alloc;
+		iss >> timing.wall >> timing.user >> timing.sys >> timing.rss >> a.nb_alloc >> a.nb_free >> a.bytes >> a.cur >> a.peak >> nb_timing;
+		v_timing.resize( nb_timing );
+		for( size_t i=0; i<nb_timing && iss; i++ )
+		{
+			KUT_TIMING& t = v_timing[i];
+			iss >> len;
+			iss.get();
+			t.name.assign( len, ' ' );
+			iss.read( &t.name[0], len );
+			iss >> t.wall >> t.user >> t.sys >> t.rss;
+			t.type = 2;
+		}
+		return !iss.fail();
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Thrown on failure in "StopTestOnFail" mode, to end the unit test (see kut_premature_end()), caught by KUT_MASTER::RunTest()
+/**
+Does not derive from std::exception, so the test code catching those does not stop it.
+*/
+struct KUT_STOP_TEST
+{
+	KUT_TYPE data; ///< counters of the unit test when it stopped
+};
+
+/// Ends the unit test on failure (StopTestOnFail mode): the run then stops, once the unit tests already started have ended
+/**
+The unit test ends by throwing KUT_STOP_TEST, and no other unit test is started (see KUT_MASTER::StopRun), in every mode.
+In a thread started inside the unit test (see KUT_THREAD_START), the failure is only recorded with \c DoQuit,
+the unit test stopping the run when it ends.
+Outside of any unit test, it writes everything that is still buffered to the log file, and exits.
+*/
+inline void kut_premature_end( const KUT_TYPE& kut_data )
+{
+	if( kut_ctx == &kut_main_context )
+	{
+		kut_main_context.Flush( kut_logsink );
+		kut_logsink.Close();
+		exit(1);
+	}
+	if( kut_ctx->owner != kut_ctx )
+		return;
+	KUT_STOP_TEST stop = { kut_data };
+	throw stop;
+}
+
+//-------------------------------------------------------------------------------------------
+/// Signal handler, installed by KUT_MAIN_START: writes the received signal to the log file and to stderr, before the crash
+/**
+Only async-signal-safe functions are called here: the message is formatted by hand in a local buffer, and written with write(2).
+*/
+inline void kut_crash_handler( int sig )
+{
+#ifdef KUT_HAS_FORK
+	static const struct { int sig; const char* name; } names[] = {
+		{ SIGSEGV, "SIGSEGV" }, { SIGBUS, "SIGBUS" }, { SIGFPE, "SIGFPE" }, { SIGILL, "SIGILL" }, { SIGABRT, "SIGABRT" }
+	};
+	char buf[128];
+	size_t len = 0;
+	const char* head = "\nKUT: CRASH, received signal ";
+	while( *head )
+		buf[len++] = *head++;
+
+	char digits[12];
+	size_t nb_digits = 0;
+	unsigned int u = sig < 0 ? 0 : sig;
+	do
+	{
+		digits[nb_digits++] = char( '0' + u % 10 );
+		u /= 10;
+	}
+	while( u );
+	while( nb_digits )
+		buf[len++] = digits[--nb_digits];
+
+	for( size_t i=0; i<sizeof(names)/sizeof(names[0]); i++ )
+		if( names[i].sig == sig )
+		{
+			buf[len++] = ' ';
+			buf[len++] = '(';
+			for( const char* c=names[i].name; *c; c++ )
+				buf[len++] = *c;
+			buf[len++] = ')';
+		}
+	buf[len++] = '\n';
+
+	if( kut_fork_fd < 0 && kut_logsink.fd >= 0 && kut_logsink.IsOwner() )   // a child process has no log file, the parent process records the crash
+		while( write( kut_logsink.fd, buf, len ) < 0 && errno == EINTR )
+			;
+	while( write( 2, buf, len ) < 0 && errno == EINTR )
+		;
+#endif
+	signal( sig, SIG_DFL );
+	raise( sig );
+}
+
+/// Installs kut_crash_handler() for the signals that end the application
+inline void kut_install_crash_handler()
+{
+#ifdef KUT_HAS_FORK
+	const int sigs[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+	for( size_t i=0; i<sizeof(sigs)/sizeof(int); i++ )
+		signal( sigs[i], kut_crash_handler );
+#endif
+}
+
+//-------------------------------------------------------------------------------------------
+/// Runs \c func( task_index, worker_index ) for all the tasks in [0,nb_tasks[, using \c nb_workers threads
+/**
+Each worker takes the next task available, so the load gets balanced even if the tasks have very different durations.
+*/
+template<typename FUNC>
+void kut_parallel_for( size_t nb_tasks, unsigned int nb_workers, FUNC func )
+{
+	if( nb_workers > nb_tasks )
+		nb_workers = (unsigned int)nb_tasks;
+	std::atomic<size_t> next_task( 0 );
+	std::vector<std::thread> v_workers;
+	for( unsigned int w=0; w<nb_workers; w++ )
+		v_workers.push_back( std::thread( [&func,&next_task,nb_tasks,w]()
+		{
+			for( size_t i=next_task++; i<nb_tasks; i=next_task++ )
+				func( i, w );
+		} ) );
+	for( size_t w=0; w<v_workers.size(); w++ )
+		v_workers[w].join();
+}
+
+//-------------------------------------------------------------------------------------------
+/// A unit test added to the registry by KUT_DEF_TEST_METHOD or KUT_TEST_FUNCTION (see \ref autoreg)
+struct KUT_REG_ENTRY
+{
+	KUT_UNIT_TEST ut;
+	const char*   file;
+	int           line;
+
+	KUT_REG_ENTRY( const KUT_UNIT_TEST& u, const char* f, int l ) : ut(u), file(f), line(l)
+	{}
+};
+
+/// The registry of the unit tests. A function holding a static, so it is usable during the static initialization of any file
+inline std::vector<KUT_REG_ENTRY>& kut_registry()
+{
+	static std::vector<KUT_REG_ENTRY> registry;
+	return registry;
+}
+
+/// A static instance of this adds a unit test to the registry, before main() is called
+struct KUT_REGISTRAR
+{
+	KUT_REGISTRAR( const char* name, int type, KUT_UT_FUNC func, const char* file, int line )
+	{
+		kut_registry().push_back( KUT_REG_ENTRY( KUT_UNIT_TEST( name, type, func ), file, line ) );
+	}
+};
+
+/// Splits the list of types \c s, as written in KUT_TYPED_TEST, at the commas that are not inside brackets
+inline std::vector<std::string> kut_split_types( const char* s )
+{
+	std::vector<std::string> v( 1 );
+	int depth = 0;
+	for( ; *s; s++ )
+	{
+		if( *s == '<' || *s == '(' || *s == '[' )
+			depth++;
+		if( *s == '>' || *s == ')' || *s == ']' )
+			depth--;
+		if( *s == ',' && depth == 0 )
+			v.push_back( std::string() );
+		else if( *s != ' ' || !v.back().empty() )
+			v.back() += *s;
+	}
+	for( size_t i=0; i<v.size(); i++ )
+		v[i].erase( v[i].find_last_not_of( ' ' ) + 1 );
+	return v;
+}
+
+/// A static instance of this adds one unit test per type of \c TYPES to the registry, before main() is called (see KUT_TYPED_TEST)
+/**
+\c L gives the function running the unit test for a type \c T, with <code>L::Func<T>()</code>.
+The unit tests are named <code>name<type></code>, the types being spelled as in \c types.
+*/
+template<typename L, typename... TYPES>
+struct KUT_TYPED_REGISTRAR
+{
+	KUT_TYPED_REGISTRAR( const char* name, int type, const char* types, const char* file, int line )
+	{
+		const KUT_UT_FUNC v_func[] = { L::template Func<TYPES>()... };
+		std::vector<std::string> v_type = kut_split_types( types );
+		for( size_t i=0; i<sizeof...(TYPES); i++ )
+		{
+			std::string full = std::string( name ) + '<' + ( i < v_type.size() ? v_type[i] : "?" ) + '>';
+			kut_registry().push_back( KUT_REG_ENTRY( KUT_UNIT_TEST( full.c_str(), type, v_func[i] ), file, line ) );
+		}
+	}
+};
+
+/// Private macros, build a name unique in the file
+#define KUT_P_CONCAT2( a, b ) a##b
+#define KUT_P_CONCAT( a, b ) KUT_P_CONCAT2( a, b )
+
+//-------------------------------------------------------------------------------------------
+/// Returns true if \c s matches the glob pattern \c p (\c * matches any sequence of characters, \c ? any character)
+inline bool kut_glob_match( const char* p, const char* s )
+{
+	const char* star = 0;
+	const char* back = 0;
+	while( *s )
+	{
+		if( *p == '*' )
+		{
+			star = ++p;
+			back = s;
+		}
+		else if( *p == '?' || *p == *s )
+		{
+			p++;
+			s++;
+		}
+		else if( star )
+		{
+			p = star;
+			s = ++back;
+		}
+		else
+			return false;
+	}
+	while( *p == '*' )
+		p++;
+	return *p == 0;
+}
+
+//-------------------------------------------------------------------------------------------
+/// Base class of the reporters, that get the results of each unit test as soon as it is merged (see \ref reporters)
+/**
+Results are given in the order of the unit tests, whatever the mode (parallel, forked).
+A reporter is expected to write (and flush) its output as it goes, so it can be read while the tests are running.
+*/
+struct KUT_REPORTER
+{
+	virtual ~KUT_REPORTER() {}
+/// Called once all the unit tests have been added (before any call to TestEnd())
+	virtual void RunStart() {}
+/// Called for each unit test, \c id starts at 1
+	virtual void TestEnd( int id, const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data ) = 0;
+/// Called for each unit test not run, as it passed before and its sources have not changed (see \ref cache)
+	virtual void TestCached( const KUT_UNIT_TEST& ) {}
+/// Called at the end, with the totals
+	virtual void RunEnd( int nb_unit_tests, int nb_ut_failures, int nb_tests, int nb_failures ) = 0;
+};
+
+/// Escapes a string for a XML attribute or text
+inline std::string kut_xml_escape( const std::string& s )
+{
+	std::string out;
+	for( size_t i=0; i<s.size(); i++ )
+		switch( s[i] )
+		{
+			case '&':  out += "&amp;";  break;
+			case '<':  out += "&lt;";   break;
+			case '>':  out += "&gt;";   break;
+			case '"':  out += "&quot;"; break;
+			case '\'': out += "&apos;"; break;
+			default:   out += s[i];
+		}
+	return out;
+}
+
+/// Escapes a string for a JSON value (quotes included)
+inline std::string kut_json_escape( const std::string& s )
+{
+	std::string out( 1, '"' );
+	for( size_t i=0; i<s.size(); i++ )
+	{
+		unsigned char c = s[i];
+		if( c == '"' || c == '\\' )
+			out += '\\';
+		if( c < 0x20 )
+		{
+			char buf[8];
+			snprintf( buf, sizeof(buf), "\\u%04x", c );
+			out += buf;
+		}
+		else
+			out += c;
+	}
+	return out + '"';
+}
+
+//-------------------------------------------------------------------------------------------
+/// Writes a JUnit XML file: one \c testsuite element holding one \c testcase per unit test, each failure being a \c failure element
+/**
+As the totals are only known at the end, they are not written as attributes of the \c testsuites root element.
+*/
+struct KUT_REPORTER_JUNIT : public KUT_REPORTER
+{
+	std::ofstream f;
+
+	KUT_REPORTER_JUNIT( const std::string& fname ) : f( fname.c_str() )
+	{
+		if( !f.is_open() )
+		{
+			std::cout << "KUT: Unable to open JUnit file " << fname << ", exiting..." << ENDL;
+			exit(1);
+		}
+		f << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites name=\"kut\">\n";
+		f.flush();
+	}
+	void TestEnd( int, const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data )
+	{
+		std::string name = kut_xml_escape( ut.name );
+		f << " <testsuite name=\"" << name << "\" tests=\"1\" failures=\"" << ( kut_data.count_fail ? 1 : 0 )
+			<< "\" time=\"" << ut.timing.wall << "\">\n";
+		if( kut_alloc_hooked )
+		{
+			const KUT_ALLOC_COUNT& a = ut.timing.alloc;
+			f << "  <properties>\n"
+				<< "   <property name=\"allocations\" value=\"" << a.nb_alloc << "\"/>\n"
+				<< "   <property name=\"alloc_bytes\" value=\"" << a.bytes << "\"/>\n"
+				<< "   <property name=\"alloc_peak\" value=\"" << a.peak << "\"/>\n"
+				<< "   <property name=\"alloc_not_freed\" value=\"" << a.cur << "\"/>\n"
+				<< "  </properties>\n";
+		}
+		f << "  <testcase name=\"" << name << "\" classname=\"" << (ut.type==0 ? "class" : "function")
+			<< "\" assertions=\"" << kut_data.count_test << "\" time=\"" << ut.timing.wall << '"';
+		if( kut_data.count_fail == 0 )
+			f << "/>\n";
+		else
+		{
+			f << ">\n";
+			for( size_t i=0; i<ut.fail_file.size(); i++ )
+				f << "   <failure type=\"assertion\" message=\"" << kut_xml_escape( ut.fail_file[i] ) << ':' << ut.fail_line[i] << "\"/>\n";
+			if( ut.fail_file.empty() )
+				f << "   <failure type=\"assertion\" message=\"" << kut_data.count_fail << " failure(s)\"/>\n";
+			f << "  </testcase>\n";
+		}
+		f << " </testsuite>\n";
+		f.flush();
+	}
+	void TestCached( const KUT_UNIT_TEST& ut )
+	{
+		std::string name = kut_xml_escape( ut.name );
+		f << " <testsuite name=\"" << name << "\" tests=\"1\" failures=\"0\" skipped=\"1\" time=\"0\">\n"
+			<< "  <testcase name=\"" << name << "\" classname=\"" << (ut.type==0 ? "class" : "function") << "\" time=\"0\">\n"
+			<< "   <skipped message=\"cached\"/>\n"
+			<< "  </testcase>\n"
+			<< " </testsuite>\n";
+		f.flush();
+	}
+	void RunEnd( int, int, int, int )
+	{
+		f << "</testsuites>\n";
+		f.close();
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Writes a NDJSON file: one JSON object per line, an event \c start, an event \c test for each unit test, and an event \c end
+struct KUT_REPORTER_JSON : public KUT_REPORTER
+{
+	std::ofstream f;
+
+	KUT_REPORTER_JSON( const std::string& fname ) : f( fname.c_str() )
+	{
+		if( !f.is_open() )
+		{
+			std::cout << "KUT: Unable to open JSON file " << fname << ", exiting..." << ENDL;
+			exit(1);
+		}
+	}
+	void RunStart()
+	{
+		f << "{\"event\":\"start\",\"version\":\"" << KUT_VERSION << "\"}\n";
+		f.flush();
+	}
+	void TestEnd( int id, const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data )
+	{
+		f << "{\"event\":\"test\",\"id\":" << id << ",\"name\":" << kut_json_escape( ut.name )
+			<< ",\"type\":\"" << (ut.type==0 ? "class" : "function") << "\",\"duration\":" << ut.timing.wall
+			<< ",\"cpu_user\":" << ut.timing.user << ",\"cpu_sys\":" << ut.timing.sys << ",\"rss_delta_kb\":" << ut.timing.rss
+			<< ",\"assertions\":" << kut_data.count_test << ",\"failures\":" << kut_data.count_fail;
+		if( kut_alloc_hooked )
+		{
+			const KUT_ALLOC_COUNT& a = ut.timing.alloc;
+			f << ",\"allocations\":" << a.nb_alloc << ",\"alloc_bytes\":" << a.bytes << ",\"alloc_peak\":" << a.peak
+				<< ",\"alloc_not_freed\":" << a.cur;
+		}
+		f << ",\"failed_at\":[";
+		for( size_t i=0; i<ut.fail_file.size(); i++ )
+			f << (i ? "," : "") << "{\"file\":" << kut_json_escape( ut.fail_file[i] ) << ",\"line\":" << ut.fail_line[i] << '}';
+		f << "]}\n";
+		f.flush();
+	}
+	void TestCached( const KUT_UNIT_TEST& ut )
+	{
+		f << "{\"event\":\"cached\",\"name\":" << kut_json_escape( ut.name ) << ",\"type\":\"" << (ut.type==0 ? "class" : "function") << "\"}\n";
+		f.flush();
+	}
+	void RunEnd( int nb_unit_tests, int nb_ut_failures, int nb_tests, int nb_failures )
+	{
+		f << "{\"event\":\"end\",\"unit_tests\":" << nb_unit_tests << ",\"unit_test_failures\":" << nb_ut_failures
+			<< ",\"tests\":" << nb_tests << ",\"failures\":" << nb_failures << "}\n";
+		f.close();
+	}
+};
+
+#ifdef KUT_HAS_FORK
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, holds a child process running a unit test (see \ref forked)
+struct KUT_CHILD
+{
+	pid_t       pid;
+	int         fd;        ///< read end of the pipe
+	size_t      index;     ///< index of the unit test in the queue
+	std::string data;      ///< what has been received so far from the child
+	bool        timed_out; ///< true if killed because it was too long
+	std::chrono::steady_clock::time_point start;
+	KUT_WATCH*  watch;     ///< time budget and progress of the unit test, in memory shared with the child process
+	int64_t     expired;   ///< steady clock when its time budget was exceeded, in ns, 0 if not
+};
+#endif
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, a unit test running in this process, checked by the watchdog thread (see \ref watchdog)
+struct KUT_RUNNING_TEST
+{
+	KUT_UNIT_TEST* ut;
+	KUT_CONTEXT*   ctx;
+	size_t         line_base; ///< see KUT_MASTER::RunTest()
+};
+
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, holds several counters.
+struct KUT_MASTER
+{
+	int NbTestTot;
+	int NbFailureTot;
+	int NbUnitTests;
+	int NbUTFailures;
+	std::vector<std::string> v_failed_test_name;    ///< name of class/function whose test failed
+	std::vector<int>         v_failed_test_type;    ///< 0 for a class, 1 for a function
+	std::vector<size_t>      v_failed_test_logline; ///< logfile line where this failure is reported, see KUT_CONTEXT::line_counter
+	unsigned int               NbJobs;      ///< nb of worker threads (or processes), see \ref parallel
+	bool                       ForkMode;    ///< if true, each unit test is run in a child process, see \ref forked
+	double                     TestTimeout; ///< default time budget of each unit test (seconds), 0 for none, see \ref watchdog
+	double                     GlobalTimeout; ///< time budget of the whole run (seconds), 0 for none
+	bool                       GlobalExpired; ///< true once GlobalTimeout is exceeded
+	int                        NbNotRun;    ///< nb of unit tests not run because GlobalTimeout was exceeded, or because the run was stopped
+	std::atomic<bool>          StopRun;     ///< set when a unit test fails in "StopTestOnFail" mode: no other unit test is started, see kut_premature_end()
+	std::string                BaselineFile;   ///< file holding the reference durations of the benchmarks, see \ref bench
+	bool                       UpdateBaseline; ///< if true, the baseline file is rewritten at the end with the new durations
+	std::map<std::string,double> m_bench_median; ///< median duration of each benchmark run
+	std::string                BinLogFile;  ///< binary log file name, empty if not used (see \ref binlog)
+	std::ofstream              BinLog;
+	std::map<std::string,uint32_t> m_string_id; ///< string table of the binary log file
+	int64_t                    StartTime;   ///< steady clock, in ns
+	std::vector<KUT_UNIT_TEST> v_queue;     ///< unit tests waiting to be run by the worker threads
+	size_t                     NbMerged;    ///< nb of unit tests of \c v_queue whose results are merged, see MergeQueued()
+	std::vector<std::unique_ptr<KUT_REPORTER> > v_reporter; ///< see \ref reporters
+	bool                       RunStarted;  ///< true once KUT_REPORTER::RunStart() has been called
+	bool                       ListOnly;    ///< if true, the registered unit tests are listed instead of being run (see \ref autoreg)
+	bool                       Shuffle;     ///< if true, the registered unit tests are run in a random order
+	unsigned int               ShuffleSeed;
+	std::string                Filter;      ///< glob patterns selecting the unit tests to run, see \ref sharding
+	unsigned int               ShardIndex;  ///< index of the shard run by this program, in [0,ShardCount[
+	unsigned int               ShardCount;  ///< nb of shards the unit tests are split into
+	std::string                ShardTimings; ///< timings file of a previous run, used to balance the shards, see \ref sharding
+	unsigned int               NbSelected;  ///< nb of unit tests that matched the filter so far
+	int                        NbNotSelected; ///< nb of unit tests skipped by the filter or by the sharding
+	std::vector<KUT_TIMING>    v_timing;    ///< resources used by each unit test and each KUT_EXECFUNC call, see \ref timings
+	int                        NbSlowest;   ///< nb of lines of the table of the slowest tests printed at the end
+	std::string                TimingsFile; ///< file where the timings are written at the end, empty if none
+	std::mutex                 WatchMutex;  ///< protects v_running, and the results while the watchdog thread ends the run
+	std::condition_variable    WatchCond;
+	std::thread                WatchThread; ///< the watchdog thread, not used in fork mode (the parent process checks the child processes)
+	bool                       WatchStop;
+	std::vector<KUT_RUNNING_TEST> v_running; ///< unit tests running in this process
+	bool                       ChangedOnly; ///< if true, the unit tests that passed and whose sources have not changed are not run, see \ref cache
+	std::string                CacheFile;   ///< file holding the hash of the sources and the last result of each unit test
+	std::string                DepDir;      ///< directory searched (recursively) for the dependency files (.d) written by the compiler
+	int                        NbCached;    ///< nb of unit tests not run, as unchanged since they passed
+	std::map<std::string,std::pair<uint64_t,bool> > m_cache; ///< hash of the sources and result (true: passed) of each unit test
+	std::map<std::string,std::vector<std::string> > m_deps;  ///< dependencies of each source file, read from the dependency files
+	std::map<std::string,uint64_t> m_file_hash; ///< hash of the content of each file read so far, 0 if it can not be read
+
+	KUT_MASTER()
+	{
+		NbTestTot    = 0;
+		NbFailureTot = 0;
+		NbUnitTests  = 0;
+		NbUTFailures = 0;
+		NbJobs       = 1;
+		ForkMode     = false;
+		TestTimeout  = 0.;
+		GlobalTimeout = 0.;
+		GlobalExpired = false;
+		NbNotRun     = 0;
+		NbMerged     = 0;
+		StopRun      = false;
+		WatchStop    = false;
+		BaselineFile   = KUT_BASELINE_FILENAME;
+		UpdateBaseline = false;
+		RunStarted     = false;
+		ListOnly       = false;
+		Shuffle        = false;
+		ShuffleSeed    = (unsigned int)time(0);
+		ShardIndex     = 0;
+		ShardCount     = 1;
+		NbSelected     = 0;
+		NbNotSelected  = 0;
+		NbSlowest      = 10;
+		ChangedOnly    = false;
+		CacheFile      = KUT_CACHE_FILENAME;
+		DepDir         = ".";
+		NbCached       = 0;
+		StartTime = kut_steady_ns();
+	}
+
+	~KUT_MASTER()
+	{
+		StopWatchdog();
+	}
+
+/// Reads the options, from the environment and from the command line (see \ref parallel and \ref forked)
+	void ParseArgs( int argc, char** argv )
+	{
+		const char* env = getenv( "KUT_JOBS" );
+		if( env )
+			NbJobs = ParseNbJobs( env );
+		env = getenv( "KUT_FORK" );
+		if( env )
+			SetForkMode( atoi( env ) != 0 );
+		env = getenv( "KUT_TIMEOUT" );
+		if( env )
+			TestTimeout = atof( env );
+		env = getenv( "KUT_GLOBAL_TIMEOUT" );
+		if( env )
+			GlobalTimeout = atof( env );
+		env = getenv( "KUT_BINLOG" );
+		if( env )
+			BinLogFile = env;
+		env = getenv( "KUT_SLOWEST" );
+		if( env )
+			NbSlowest = atoi( env );
+		env = getenv( "KUT_TIMINGS" );
+		if( env )
+			TimingsFile = env;
+		env = getenv( "KUT_FILTER" );
+		if( env )
+			Filter = env;
+		env = getenv( "KUT_SHARD_INDEX" );
+		if( env )
+			ShardIndex = atoi( env );
+		env = getenv( "KUT_SHARD_COUNT" );
+		if( env )
+			ShardCount = atoi( env );
+		env = getenv( "KUT_SHARD_TIMINGS" );
+		if( env )
+			ShardTimings = env;
+		env = getenv( "KUT_CHANGED_ONLY" );
+		if( env )
+			ChangedOnly = atoi( env ) != 0;
+		env = getenv( "KUT_DEPDIR" );
+		if( env )
+			DepDir = env;
+		env = getenv( "KUT_JUNIT" );
+		if( env )
+			AddReporter( new KUT_REPORTER_JUNIT( env ) );
+		env = getenv( "KUT_JSON" );
+		if( env )
+			AddReporter( new KUT_REPORTER_JSON( env ) );
+		for( int i=1; i<argc; i++ )
+		{
+			std::string arg( argv[i] );
+			if( arg.compare( 0, 7, "--jobs=" ) == 0 )
+				NbJobs = ParseNbJobs( arg.c_str()+7 );
+			if( arg.compare( 0, 2, "-j" ) == 0 && arg.size() > 2 )
+				NbJobs = ParseNbJobs( arg.c_str()+2 );
+			if( arg == "--fork" )
+				SetForkMode( true );
+			if( arg.compare( 0, 10, "--timeout=" ) == 0 )
+				TestTimeout = atof( arg.c_str()+10 );
+			if( arg.compare( 0, 17, "--global-timeout=" ) == 0 )
+				GlobalTimeout = atof( arg.c_str()+17 );
+			if( arg.compare( 0, 11, "--baseline=" ) == 0 )
+				BaselineFile = arg.substr( 11 );
+			if( arg == "--update-baseline" )
+				UpdateBaseline = true;
+			if( arg.compare( 0, 9, "--binlog=" ) == 0 )
+				BinLogFile = arg.substr( 9 );
+			if( arg == "--list" )
+				ListOnly = true;
+			if( arg == "--shuffle" )
+				Shuffle = true;
+			if( arg.compare( 0, 10, "--shuffle=" ) == 0 )
+			{
+				Shuffle     = true;
+				ShuffleSeed = (unsigned int)strtoul( arg.c_str()+10, 0, 10 );
+			}
+			if( arg.compare( 0, 9, "--filter=" ) == 0 )
+				Filter = arg.substr( 9 );
+			if( arg.compare( 0, 14, "--shard-index=" ) == 0 )
+				ShardIndex = atoi( arg.c_str()+14 );
+			if( arg.compare( 0, 14, "--shard-count=" ) == 0 )
+				ShardCount = atoi( arg.c_str()+14 );
+			if( arg.compare( 0, 16, "--shard-timings=" ) == 0 )
+				ShardTimings = arg.substr( 16 );
+			if( arg.compare( 0, 10, "--slowest=" ) == 0 )
+				NbSlowest = atoi( arg.substr( 10 ).c_str() );
+			if( arg.compare( 0, 10, "--timings=" ) == 0 )
+				TimingsFile = arg.substr( 10 );
+			if( arg == "--changed-only" )
+				ChangedOnly = true;
+			if( arg.compare( 0, 8, "--cache=" ) == 0 )
+				CacheFile = arg.substr( 8 );
+			if( arg.compare( 0, 9, "--depdir=" ) == 0 )
+				DepDir = arg.substr( 9 );
+			if( arg.compare( 0, 8, "--junit=" ) == 0 )
+				AddReporter( new KUT_REPORTER_JUNIT( arg.substr( 8 ) ) );
+			if( arg.compare( 0, 7, "--json=" ) == 0 )
+				AddReporter( new KUT_REPORTER_JSON( arg.substr( 7 ) ) );
+		}
+	}
+
+/// Prints the table of the \c NbSlowest unit tests (or KUT_EXECFUNC calls) with the longest wall clock time, to the log file and to stdout
+	void PrintSlowest()
+	{
+		if( NbSlowest <= 0 || v_timing.empty() )
+			return;
+		std::vector<const KUT_TIMING*> v( v_timing.size() );
+		for( size_t i=0; i<v.size(); i++ )
+			v[i] = &v_timing[i];
+		size_t nb = std::min( v.size(), (size_t)NbSlowest );
+		std::partial_sort( v.begin(), v.begin()+nb, v.end(), []( const KUT_TIMING* a, const KUT_TIMING* b ){ return a->wall > b->wall; } );
+
+		std::ostringstream oss;
+		oss << " - Slowest tests:\n"
+			<< "        wall        user         sys  peak RSS +kB  name\n";
+		for( size_t i=0; i<nb; i++ )
+		{
+			char buf[80];
+			snprintf( buf, sizeof(buf), "%12s%12s%12s%14ld  ",
+				kut_format_duration( v[i]->wall ).c_str(), kut_format_duration( v[i]->user ).c_str(),
+				kut_format_duration( v[i]->sys ).c_str(), v[i]->rss );
+			oss << buf << (v[i]->type==0 ? "class " : (v[i]->type==1 ? "function " : "local function ")) << v[i]->name << '\n';
+		}
+		KUT_LOG2 << oss.str();
+		kut_ctx->line_counter += nb + 2;
+		std::cout << oss.str();
+	}
+
+/// Writes the timings of all the unit tests and KUT_EXECFUNC calls to \c TimingsFile, one per line, separated by tabulations (see \ref timings)
+	void WriteTimings() const
+	{
+		if( TimingsFile.empty() )
+			return;
+		std::ofstream f( TimingsFile.c_str() );
+		if( !f.is_open() )
+		{
+			std::cout << "KUT: Unable to write timings file " << TimingsFile << ENDL;
+			return;
+		}
+		f << "# wall\tuser\tsys\trss_kb\ttype\tname\n";
+		f.precision( 9 );
+		for( size_t i=0; i<v_timing.size(); i++ )
+		{
+			const KUT_TIMING& t = v_timing[i];
+			f << t.wall << '\t' << t.user << '\t' << t.sys << '\t' << t.rss << '\t' << t.type << '\t' << t.name << '\n';
+		}
+	}
+
+/// Adds the unit tests of the registry, sorted by file and line (the order of the static initialization of the files is not defined), see \ref autoreg
+/**
+With \c --list, the tests are only printed, and the program ends.
+*/
+	void AddRegisteredTests()
+	{
+		std::vector<KUT_REG_ENTRY> v( kut_registry() );
+		std::stable_sort( v.begin(), v.end(), []( const KUT_REG_ENTRY& a, const KUT_REG_ENTRY& b )
+		{
+			int c = strcmp( a.file, b.file );
+			return c < 0 || ( c == 0 && a.line < b.line );
+		} );
+		if( !ListOnly )   // the shards are dealt in this stable order, so they do not overlap when each program shuffles with its own seed
+		{
+			std::vector<KUT_REG_ENTRY> v_selected;
+			for( size_t i=0; i<v.size(); i++ )
+				if( Select( v[i].ut ) )
+					v_selected.push_back( v[i] );
+			v.swap( v_selected );
+		}
+		if( Shuffle )
+		{
+			std::mt19937 rng( ShuffleSeed );
+			std::shuffle( v.begin(), v.end(), rng );
+			KUT_LOG << " - unit tests shuffled, seed=" << ShuffleSeed << ENDL;
+			std::cout << " - unit tests shuffled, seed=" << ShuffleSeed << ENDL;
+		}
+		if( ListOnly )
+		{
+			for( size_t i=0; i<v.size(); i++ )
+				std::cout << (v[i].ut.type==0 ? "class " : "function ") << v[i].ut.name << " (" << v[i].file << ':' << v[i].line << ")\n";
+			std::cout.flush();
+			exit(0);
+		}
+		for( size_t i=0; i<v.size(); i++ )
+		{
+			v[i].ut.file = v[i].file;
+			AddUnitTest( v[i].ut, true );
+		}
+	}
+
+/// Adds a reporter, that will be deleted at the end (see \ref reporters)
+	void AddReporter( KUT_REPORTER* rep )
+	{
+		v_reporter.push_back( std::unique_ptr<KUT_REPORTER>( rep ) );
+	}
+
+/// Called by KUT_MAIN_END, once all the unit tests are done
+	void EndReport()
+	{
+		if( !RunStarted )
+			for( size_t i=0; i<v_reporter.size(); i++ )
+				v_reporter[i]->RunStart();
+		for( size_t i=0; i<v_reporter.size(); i++ )
+			v_reporter[i]->RunEnd( NbUnitTests, NbUTFailures, NbTestTot, NbFailureTot );
+		v_reporter.clear();
+	}
+
+/// Called by KUT_MAIN_START, once the log file is opened
+	void Init()
+	{
+		if( ShardCount < 1 || ShardIndex >= ShardCount )
+		{
+			std::cout << "KUT: invalid shard " << ShardIndex << " of " << ShardCount << ", exiting..." << ENDL;
+			exit(1);
+		}
+		if( !Filter.empty() )
+			KUT_LOG << " - filter: " << Filter << ENDL;
+		if( ShardCount > 1 )
+			KUT_LOG << " - shard " << ShardIndex << " of " << ShardCount << (ShardTimings.empty() ? "" : ", balanced with timings file " ) << ShardTimings << ENDL;
+		ReadBaseline();
+		if( ChangedOnly )
+		{
+			ReadCache();
+			ReadDeps( DepDir );
+			KUT_LOG << " - changed-only mode, cache file " << CacheFile << ", " << m_deps.size() << " dependency files read from " << DepDir << ENDL;
+		}
+		if( !BinLogFile.empty() )
+			OpenBinLog();
+		if( !ForkMode )
+			WatchThread = std::thread( [this]() { Watchdog(); } );
+	}
+
+/// Stops the watchdog thread, called by KUT_MAIN_END
+	void StopWatchdog()
+	{
+		if( !WatchThread.joinable() )
+			return;
+		{
+			std::lock_guard<std::mutex> lock( WatchMutex );
+			WatchStop = true;
+		}
+		WatchCond.notify_one();
+		WatchThread.join();
+	}
+
+/// The watchdog thread: stops the unit tests that exceed their time budget, then ends the run (see \ref watchdog)
+/**
+A unit test over its budget is asked to stop at its next test (see kut_watch_expired()). A unit test that ends by itself
+in the meantime is only recorded as failed. Once the unit tests asked have all stopped, or after KUT_TIMEOUT_GRACE seconds,
+the other unit tests running are asked to stop too, and the run ends with WatchdogAbort().
+*/
+	void Watchdog()
+	{
+		std::unique_lock<std::mutex> lock( WatchMutex );
+		int64_t stop_time = 0;   // when the first unit test was asked to stop
+		while( !WatchCond.wait_for( lock, std::chrono::milliseconds( 100 ), [this]() { return WatchStop; } ) )
+		{
+			int64_t now = kut_steady_ns();
+			if( GlobalTimeout > 0. && now - StartTime > GlobalTimeout*1E9 )
+				GlobalExpired = true;
+			if( !RequestStop( now, GlobalExpired ) )
+			{
+				stop_time = 0;
+				continue;
+			}
+			if( !stop_time )
+				stop_time = now;
+			if( !AllStopped() && now - stop_time < KUT_TIMEOUT_GRACE*1E9 )
+				continue;
+			RequestStop( now, true );
+			for( int64_t end = kut_steady_ns() + (int64_t)( KUT_TIMEOUT_GRACE*1E9 ); !AllStopped() && kut_steady_ns() < end; )
+				WatchCond.wait_for( lock, std::chrono::milliseconds( 10 ) );
+			WatchdogAbort();
+		}
+	}
+
+/// Asks the unit tests running to stop: the ones over their budget, or all of them. Returns true if one of them at least is asked to stop (or if \c all)
+	bool RequestStop( int64_t now, bool all )
+	{
+		bool any = all;
+		for( size_t i=0; i<v_running.size(); i++ )
+		{
+			KUT_WATCH& w = *v_running[i].ctx->watch;
+			int state = 0;
+			if( all || w.Exceeded( now ) )
+				w.state.compare_exchange_strong( state, 1 );
+			if( w.state != 0 )
+				any = true;
+		}
+		return any;
+	}
+
+/// Returns false if a unit test asked to stop is still running
+	bool AllStopped() const
+	{
+		for( size_t i=0; i<v_running.size(); i++ )
+			if( v_running[i].ctx->watch->state.load( std::memory_order_acquire ) == 1 )
+				return false;
+		return true;
+	}
+
+/// Called by the watchdog thread: merges the results so far, records the unit tests still running as failed, writes the summary, and ends the test application
+	void WatchdogAbort()
+	{
+		if( v_queue.empty() )   // unit tests run one by one: the header of the running one is already written
+			for( size_t i=0; i<v_running.size(); i++ )
+			{
+				SetAborted( v_running[i] );
+				MergeResult( *v_running[i].ut );
+			}
+		for( size_t i=NbMerged; i<v_queue.size(); i++ )
+		{
+			KUT_UNIT_TEST& ut = v_queue[i];
+			const KUT_RUNNING_TEST* running = 0;
+			for( size_t j=0; j<v_running.size(); j++ )
+				if( v_running[j].ut == &ut )
+					running = &v_running[j];
+			if( !running && !ut.ended )
+			{
+				NbNotRun++;
+				continue;
+			}
+			PrintHeader( ut );
+			if( running )
+				SetAborted( *running );
+			MergeResult( ut );
+		}
+		PrintSummary();
+		std::cout.flush();
+		fflush( 0 );
+		std::_Exit( NbFailureTot );
+	}
+
+/// Sets the results of a unit test stopped by the watchdog: what it has done so far if its thread has stopped, and the timeout as a failure
+	void SetAborted( const KUT_RUNNING_TEST& r )
+	{
+		KUT_UNIT_TEST& ut = *r.ut;
+		KUT_WATCH& w = *r.ctx->watch;
+		if( w.state.load( std::memory_order_acquire ) == 2 )
+			ut.SetResult( *w.data, *r.ctx, r.line_base );
+		else   // its thread may still be writing to its context, nothing can be read from it
+		{
+			ut.result      = KUT_TYPE();
+			ut.log         = "- ABORTED unit test of " + ut.name + ": still running after the grace delay, its log is lost\n";
+			ut.nb_loglines = 1;
+		}
+		ut.timing.wall = ( ( w.stop ? w.stop : kut_steady_ns() ) - w.start.load() ) * 1E-9;
+		ut.AddTimeout( w );
+	}
+
+/// Registers a unit test that starts running in this process, for the watchdog thread
+	void Watch( KUT_UNIT_TEST& ut, KUT_CONTEXT& ctx, size_t line_base )
+	{
+		std::lock_guard<std::mutex> lock( WatchMutex );
+		ctx.watch->Start( TestTimeout );
+		KUT_RUNNING_TEST r = { &ut, &ctx, line_base };
+		v_running.push_back( r );
+	}
+
+/// Called when the unit test has ended
+	void Unwatch( KUT_CONTEXT& ctx )
+	{
+		std::lock_guard<std::mutex> lock( WatchMutex );
+		for( size_t i=0; i<v_running.size(); i++ )
+			if( v_running[i].ctx == &ctx )
+			{
+				v_running[i].ut->ended = true;
+				v_running.erase( v_running.begin()+i );
+				break;
+			}
+	}
+
+/// Opens the binary log file. The tests are then only recorded there, not in the text log file (see \ref binlog)
+	void OpenBinLog()
+	{
+		BinLog.open( BinLogFile.c_str(), std::ios::binary );
+		if( !BinLog.is_open() )
+		{
+			std::cout << "KUT: Unable to open binary log file " << BinLogFile << ", exiting..." << ENDL;
+			exit(1);
+		}
+		uint32_t record_size = sizeof( KUT_BIN_RECORD );
+		BinLog.write( KUT_BIN_MAGIC, sizeof( KUT_BIN_MAGIC ) );
+		BinLog.write( (const char*)&record_size, sizeof(uint32_t) );
+		kut_binlog  = true;
+		kut_verbose = false;
+		KUT_LOG << " - tests recorded in binary log file " << BinLogFile << ENDL;
+	}
+
+/// Returns the id of \c s in the string table of the binary log file, adding it if needed
+	uint32_t BinString( const std::string& s )
+	{
+		std::map<std::string,uint32_t>::const_iterator it = m_string_id.find( s );
+		if( it != m_string_id.end() )
+			return it->second;
+		uint32_t head[3] = { KUT_BIN_STRING, (uint32_t)m_string_id.size(), (uint32_t)s.size() };
+		BinLog.write( (const char*)head, sizeof(head) );
+		BinLog.write( s.data(), s.size() );
+		return m_string_id[s] = head[1];
+	}
+
+/// Writes the unit test and its records to the binary log file
+	void WriteBinLog( const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data )
+	{
+		std::vector<KUT_BIN_RECORD> v( ut.v_record.size() );
+		for( size_t i=0; i<v.size(); i++ )
+		{
+			const KUT_TEST_RECORD& r = ut.v_record[i];
+			v[i].test_id   = NbUnitTests;
+			v[i].file_id   = BinString( r.file );
+			v[i].expr_id   = BinString( r.expr );
+			v[i].line      = r.line;
+			v[i].index     = r.index;
+			v[i].op        = (uint8_t)r.op;
+			v[i].pass      = r.pass ? 1 : 0;
+			v[i].reserved  = 0;
+			v[i].timestamp = r.timestamp > StartTime ? r.timestamp - StartTime : 0;
+		}
+		uint32_t name_id = BinString( ut.name );
+		uint32_t head[6] = { KUT_BIN_UNIT_TEST, (uint32_t)NbUnitTests, name_id, (uint32_t)ut.type, (uint32_t)kut_data.count_test, (uint32_t)kut_data.count_fail };
+		BinLog.write( (const char*)head, sizeof(head) );
+		uint32_t head2[2] = { KUT_BIN_RECORDS, (uint32_t)v.size() };
+		BinLog.write( (const char*)head2, sizeof(head2) );
+		if( !v.empty() )
+			BinLog.write( (const char*)&v[0], v.size()*sizeof(KUT_BIN_RECORD) );
+	}
+
+/// Reads the baseline file (each line holds the median duration of a benchmark, in seconds, and its name)
+	void ReadBaseline()
+	{
+		std::ifstream f( BaselineFile.c_str() );
+		double median;
+		std::string name;
+		while( f >> median && std::getline( f >> std::ws, name ) )
+			kut_baseline[name] = median;
+	}
+
+/// Rewrites the baseline file with the durations measured, if requested. The benchmarks that were not run are kept.
+	void WriteBaseline()
+	{
+		if( !UpdateBaseline )
+			return;
+		std::map<std::string,double> m( kut_baseline );
+		for( std::map<std::string,double>::const_iterator it=m_bench_median.begin(); it!=m_bench_median.end(); ++it )
+			m[it->first] = it->second;
+		std::ofstream f( BaselineFile.c_str() );
+		f.precision( 17 );
+		for( std::map<std::string,double>::const_iterator it=m.begin(); it!=m.end(); ++it )
+			f << it->second << ' ' << it->first << '\n';
+		if( !f )
+			std::cout << "KUT: Unable to write baseline file " << BaselineFile << ENDL;
+	}
+
+/// Reads the cache file (each line holds the hash of the sources of a unit test, 1 if it passed, and its name)
+	void ReadCache()
+	{
+		std::ifstream f( CacheFile.c_str() );
+		uint64_t hash;
+		int pass;
+		std::string name;
+		while( f >> std::hex >> hash >> std::dec >> pass && std::getline( f >> std::ws, name ) )
+			m_cache[name] = std::make_pair( hash, pass != 0 );
+	}
+
+/// Rewrites the cache file, with the unit tests run. The other ones are kept.
+	void WriteCache()
+	{
+		if( !ChangedOnly )
+			return;
+		std::ofstream f( CacheFile.c_str() );
+		for( std::map<std::string,std::pair<uint64_t,bool> >::const_iterator it=m_cache.begin(); it!=m_cache.end(); ++it )
+			f << std::hex << it->second.first << std::dec << ' ' << it->second.second << ' ' << it->first << '\n';
+		if( !f )
+			std::cout << "KUT: Unable to write cache file " << CacheFile << ENDL;
+	}
+
+/// Reads the dependency files (\c .d, as written by the \c -MD option of gcc and clang) found in \c dir and its sub-directories
+/**
+Each one holds a rule <code>target: source dep1 dep2 ...</code>, the source being the first prerequisite.
+*/
+	void ReadDeps( const std::string& dir )
+	{
+#ifdef KUT_HAS_FORK
+		DIR* d = opendir( dir.c_str() );
+		if( !d )
+			return;
+		while( dirent* e = readdir( d ) )
+		{
+			std::string name( e->d_name );
+			if( name == "." || name == ".." )
+				continue;
+			std::string path = dir + '/' + name;
+			if( name.size() > 2 && name.compare( name.size()-2, 2, ".d" ) == 0 )
+				ReadDepFile( path );
+			else if( e->d_type == DT_DIR )
+				ReadDeps( path );
+			else if( e->d_type == DT_UNKNOWN )   // some file systems do not give the type, lstat() then does (not following links, as d_type)
+			{
+				struct stat st;
+				if( lstat( path.c_str(), &st ) == 0 && S_ISDIR( st.st_mode ) )
+					ReadDeps( path );
+			}
+		}
+		closedir( d );
+#else
+		(void)dir;
+#endif
+	}
+
+/// Reads one dependency file, see ReadDeps()
+	void ReadDepFile( const std::string& fname )
+	{
+		std::ifstream f( fname.c_str() );
+		std::string text, line;
+		while( std::getline( f, line ) )
+		{
+			if( !line.empty() && line[line.size()-1] == '\r' )
+				line.erase( line.size()-1 );
+			if( !line.empty() && line[line.size()-1] == '\\' )
+				line[line.size()-1] = ' ';
+			else if( !text.empty() && text.find( ':' ) != std::string::npos && line.find( ':' ) != std::string::npos )
+				break; // next rule (phony targets of -MP)
+			text += line + ' ';
+		}
+		size_t pos = text.find( ": " );
+		if( pos == std::string::npos )
+			return;
+		std::vector<std::string> v_dep;
+		std::string dep;
+		for( size_t i=pos+2; i<text.size(); i++ )
+		{
+			if( text[i] == '\\' && i+1 < text.size() && text[i+1] == ' ' )
+				dep += text[++i];
+			else if( text[i] == ' ' )
+			{
+				if( !dep.empty() )
+					v_dep.push_back( dep );
+				dep.clear();
+			}
+			else
+				dep += text[i];
+		}
+		if( !v_dep.empty() )
+			m_deps[v_dep[0]] = v_dep;
+	}
+
+/// Returns the hash of the content of the file \c fname (FNV-1a), 0 if it can not be read
+	uint64_t FileHash( const std::string& fname )
+	{
+		std::map<std::string,uint64_t>::const_iterator it = m_file_hash.find( fname );
+		if( it != m_file_hash.end() )
+			return it->second;
+		uint64_t h = 0;
+		std::ifstream f( fname.c_str(), std::ios::binary );
+		if( f.is_open() )
+		{
+			h = 14695981039346656037ULL;
+			char buf[4096];
+			while( f.read( buf, sizeof(buf) ), f.gcount() > 0 )
+				for( std::streamsize i=0; i<f.gcount(); i++ )
+					h = ( h ^ (unsigned char)buf[i] ) * 1099511628211ULL;
+			if( h == 0 )
+				h = 1;
+		}
+		return m_file_hash[fname] = h;
+	}
+
+/// Returns the hash of the source file \c file and of its dependencies, 0 if one of them can not be read
+/**
+The dependencies are those of the dependency file whose source is \c file, or ends with it (or the reverse, for relative paths).
+Without any, only \c file itself is hashed.
+*/
+	uint64_t SourceHash( const std::string& file )
+	{
+		std::vector<std::string> v_dep( 1, file );
+		std::map<std::string,std::vector<std::string> >::const_iterator it = m_deps.find( file );
+		if( it == m_deps.end() )
+			for( it=m_deps.begin(); it!=m_deps.end(); ++it )
+			{
+				const std::string& s = it->first;
+				if( ( s.size() > file.size() && s.compare( s.size()-file.size()-1, file.size()+1, '/' + file ) == 0 )
+					|| ( file.size() > s.size() && file.compare( file.size()-s.size()-1, s.size()+1, '/' + s ) == 0 ) )
+					break;
+			}
+		if( it != m_deps.end() )
+			v_dep = it->second;
+		uint64_t h = 14695981039346656037ULL;
+		for( size_t i=0; i<v_dep.size(); i++ )
+		{
+			uint64_t fh = FileHash( v_dep[i] );
+			if( fh == 0 )
+				return 0;
+			h = ( h ^ fh ) * 1099511628211ULL;
+		}
+		return h ? h : 1;
+	}
+
+/// Returns true if the unit test passed on its last run, with the same sources. Computes its hash on the way
+	bool IsCached( KUT_UNIT_TEST& ut )
+	{
+		ut.hash = SourceHash( ut.file );
+		std::map<std::string,std::pair<uint64_t,bool> >::const_iterator it = m_cache.find( ut.name );
+		return ut.hash && it != m_cache.end() && it->second.first == ut.hash && it->second.second;
+	}
+
+/// Reports a unit test not run, as unchanged since it passed
+	void AddCached( const KUT_UNIT_TEST& ut )
+	{
+		std::lock_guard<std::mutex> lock( WatchMutex );
+		NbCached++;
+		KUT_LOG << "* cached: " << (ut.type==0 ? "class " : "function ") << ut.name << ", unchanged since it passed" << ENDL;
+		if( !RunStarted )
+		{
+			for( size_t i=0; i<v_reporter.size(); i++ )
+				v_reporter[i]->RunStart();
+			RunStarted = true;
+		}
+		for( size_t i=0; i<v_reporter.size(); i++ )
+			v_reporter[i]->TestCached( ut );
+	}
+
+/// Fork mode is only available on posix systems
+	void SetForkMode( bool b )
+	{
+#ifdef KUT_HAS_FORK
+		ForkMode = b;
+#else
+		if( b )
+			std::cout << "KUT: fork mode not available on this system, ignored\n";
+#endif
+	}
+
+/// 0 (or anything not a number) means "one worker per core"
+	static unsigned int ParseNbJobs( const char* s )
+	{
+		int n = atoi( s );
+		if( n <= 0 )
+			n = (int)std::thread::hardware_concurrency();
+		return n > 0 ? n : 1;
+	}
+
+/// Returns true if \c name matches one of the glob patterns of \c list, separated by ':' (empty patterns are ignored)
+	static bool MatchList( const std::string& list, const std::string& name, bool& has_pattern )
+	{
+		has_pattern = false;
+		size_t pos = 0;
+		while( pos <= list.size() )
+		{
+			size_t end = list.find( ':', pos );
+			if( end == std::string::npos )
+				end = list.size();
+			std::string pattern = list.substr( pos, end-pos );
+			if( !pattern.empty() )
+			{
+				has_pattern = true;
+				if( kut_glob_match( pattern.c_str(), name.c_str() ) )
+					return true;
+			}
+			pos = end+1;
+		}
+		return false;
+	}
+
+/// Returns true if the unit test matches the filter: \c POSITIVE-NEGATIVE, the tests matching the patterns after the first '-' being excluded (see \ref sharding)
+	bool MatchFilter( const std::string& name ) const
+	{
+		if( Filter.empty() )
+			return true;
+		size_t dash = Filter.find( '-' );
+		std::string positive = Filter.substr( 0, dash );
+		bool has_pattern = false;
+		if( dash != std::string::npos && MatchList( Filter.substr( dash+1 ), name, has_pattern ) )
+			return false;
+		return MatchList( positive, name, has_pattern ) || !has_pattern;
+	}
+
+/// Reads the timings file of a previous run (see WriteTimings()), and keeps in the queue the unit tests of this shard
+/**
+Greedy bin-packing: the unit tests are taken by decreasing duration, each one going to the shard with the smallest total so far.
+Tests not in the file get the mean duration of the others. Ties are broken by name, so every node computes the same split.
+*/
+	void SelectShard()
+	{
+		std::map<std::string,double> m_wall;
+		std::ifstream f( ShardTimings.c_str() );
+		if( !f.is_open() )
+			std::cout << "KUT: Unable to open timings file " << ShardTimings << ", shards will not be balanced" << ENDL;
+		std::string line;
+		double sum = 0.;
+		while( std::getline( f, line ) )
+		{
+			if( line.empty() || line[0] == '#' )
+				continue;
+			std::istringstream iss( line );
+			double wall = 0., user, sys;
+			long rss;
+			int type = 0;
+			std::string name;
+			iss >> wall >> user >> sys >> rss >> type;
+			iss.get();
+			std::getline( iss, name );
+			if( iss && type != 2 )
+			{
+				m_wall[name] = wall;
+				sum += wall;
+			}
+		}
+		double mean = m_wall.empty() ? 1. : sum / m_wall.size();
+
+		std::vector<size_t> v_idx( v_queue.size() );
+		std::vector<double> v_wall( v_queue.size() );
+		for( size_t i=0; i<v_queue.size(); i++ )
+		{
+			v_idx[i] = i;
+			std::map<std::string,double>::const_iterator it = m_wall.find( v_queue[i].name );
+			v_wall[i] = it != m_wall.end() ? it->second : mean;
+		}
+		std::sort( v_idx.begin(), v_idx.end(), [&]( size_t a, size_t b )
+		{
+			if( v_wall[a] != v_wall[b] )
+				return v_wall[a] > v_wall[b];
+			return v_queue[a].name < v_queue[b].name;
+		} );
+		std::vector<double> v_load( ShardCount, 0. );
+		std::vector<bool>   v_keep( v_queue.size(), false );
+		for( size_t i=0; i<v_idx.size(); i++ )
+		{
+			size_t shard = std::min_element( v_load.begin(), v_load.end() ) - v_load.begin();
+			v_load[shard] += v_wall[v_idx[i]];
+			v_keep[v_idx[i]] = ( shard == ShardIndex );
+		}
+		std::vector<KUT_UNIT_TEST> v;
+		for( size_t i=0; i<v_queue.size(); i++ )
+			if( v_keep[i] )
+				v.push_back( v_queue[i] );
+			else
+				NbNotSelected++;
+		v_queue.swap( v );
+		KUT_LOG << " - shard " << ShardIndex << ": " << v_queue.size() << " unit tests, expected duration " << kut_format_duration( v_load[ShardIndex] ) << ENDL;
+	}
+
+/// Returns true if the unit test matches the filter, and belongs to this shard (dealt in turn, unless balanced with a timings file)
+	bool Select( const KUT_UNIT_TEST& ut )
+	{
+		if( !MatchFilter( ut.name ) )
+		{
+			NbNotSelected++;
+			return false;
+		}
+		if( ShardCount > 1 && ShardTimings.empty() && NbSelected++ % ShardCount != ShardIndex )
+		{
+			NbNotSelected++;
+			return false;
+		}
+		return true;
+	}
+
+/// Runs the unit test right away, or queues it if several worker threads are used (or if the shards are balanced with a timings file)
+/**
+Unit tests not matching the filter, or belonging to another shard, are skipped, unless \c selected is true (already checked with Select()).
+*/
+	void AddUnitTest( const KUT_UNIT_TEST& ut, bool selected = false )
+	{
+		if( !selected && !Select( ut ) )
+			return;
+		if( StopRun )
+		{
+			NbNotRun++;
+			return;
+		}
+		KUT_UNIT_TEST ut2( ut );
+		if( ChangedOnly && ut.file && IsCached( ut2 ) )
+		{
+			AddCached( ut2 );
+			return;
+		}
+		if( NbJobs > 1 || ForkMode || ( ShardCount > 1 && !ShardTimings.empty() ) )
+		{
+			v_queue.push_back( ut2 );
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock( WatchMutex );
+			PrintHeader( ut2 );
+			Flush();
+		}
+		RunTest( ut2, true );
+		std::lock_guard<std::mutex> lock( WatchMutex );
+		MergeResult( ut2 );
+	}
+
+/// Runs the queued unit tests with the worker threads, and merges the results in the order they were queued
+/**
+So the logfile, the summary and the return value are the same as in a serial run.
+Once the run is stopped (see StopRun), the workers end their current unit test and do not start other ones.
+*/
+	void RunQueue()
+	{
+		if( ShardCount > 1 && !ShardTimings.empty() )
+			SelectShard();
+		NbMerged = 0;
+		if( ForkMode )
+			RunForked();
+		else
+			kut_parallel_for( v_queue.size(), NbJobs, [this]( size_t i, unsigned int )
+			{
+				if( StopRun )
+					return;
+				RunTest( v_queue[i], false );
+				std::lock_guard<std::mutex> lock( WatchMutex );
+				MergeQueued( false );
+			} );
+		std::lock_guard<std::mutex> lock( WatchMutex );
+		MergeQueued( true );
+		v_queue.clear();
+		NbMerged = 0;
+	}
+
+/// Merges the results of the queued unit tests that have ended, in the order they were queued, up to the first one not ended yet
+/**
+Called with WatchMutex held each time a queued unit test ends, so the console and the reporters follow the run.
+If \c all is true (the run of the queue is over), the unit tests not run are counted and skipped.
+*/
+	void MergeQueued( bool all )
+	{
+		for( ; NbMerged<v_queue.size(); NbMerged++ )
+		{
+			KUT_UNIT_TEST& ut = v_queue[NbMerged];
+			if( !ut.ended )
+			{
+				if( !all )
+					return;
+				NbNotRun++;
+				continue;
+			}
+			PrintHeader( ut );
+			MergeResult( ut );
+		}
+	}
+
+/// Runs the unit test in the current thread, with its own context
+/**
+\param in_order true if the test is run while the log file is written (serial run): its line counter then starts at the current line of the log file.
+Else (worker thread, child process), it starts at 0, and the "TEMP" line numbers are not written
+\param watch in a child process, its time budget, checked by the parent process. Else the unit test is checked by the watchdog thread
+*/
+	void RunTest( KUT_UNIT_TEST& ut, bool in_order, KUT_WATCH* watch = 0 )
+	{
+		size_t line_base = in_order ? kut_ctx->line_counter : 0;
+		KUT_CONTEXT ctx( line_base, in_order );
+		if( watch )
+			ctx.watch = watch;
+		else
+			Watch( ut, ctx, line_base );
+		KUT_CONTEXT* previous_ctx = kut_ctx;
+		kut_ctx = &ctx;
+		KUT_TIMER timer;
+		ctx.alloc = &timer.alloc;
+		KUT_TYPE kut_data;
+		try
+		{
+			kut_data = ut.func();
+		}
+		catch( const KUT_STOP_TEST& stop )
+		{
+			kut_data = stop.data;
+			ctx.MergeThreadResults( kut_data );
+		}
+		ut.timing = timer.Stop( ut.name, ut.type );
+		kut_ctx = previous_ctx;
+		ctx.ReleaseFixtures();
+		ut.SetResult( kut_data, ctx, line_base );
+		if( ctx.watch->Exceeded( kut_steady_ns() ) )
+			ut.AddTimeout( *ctx.watch );
+		if( kut_data.DoQuit )
+			StopRun = true;
+		if( watch )
+			ut.ended = true;
+		else
+			Unwatch( ctx );   // sets \c ended with WatchMutex held, as it is read by MergeQueued()
+	}
+
+/// Runs each queued unit test in its own child process, with at most NbJobs processes at the same time (see \ref forked)
+	void RunForked()
+	{
+#ifdef KUT_HAS_FORK
+		std::vector<KUT_CHILD> v_child;
+		size_t next = 0;
+		while( ( next < v_queue.size() && !StopRun ) || !v_child.empty() )
+		{
+			if( !GlobalExpired && GlobalTimeout > 0. && kut_steady_ns() - StartTime > GlobalTimeout*1E9 )
+			{
+				GlobalExpired = true;
+				NbNotRun = int( v_queue.size() - next );
+				v_queue.erase( v_queue.begin()+next, v_queue.end() );
+			}
+			while( next < v_queue.size() && v_child.size() < NbJobs && !StopRun )
+				v_child.push_back( StartChild( next++ ) );
+
+			std::vector<pollfd> v_pfd( v_child.size() );
+			for( size_t i=0; i<v_child.size(); i++ )
+			{
+				v_pfd[i].fd      = v_child[i].fd;
+				v_pfd[i].events  = POLLIN;
+				v_pfd[i].revents = 0;
+			}
+			poll( &v_pfd[0], v_pfd.size(), 100 );
+
+			for( size_t i=v_child.size(); i-- > 0; )
+			{
+				KUT_CHILD& child = v_child[i];
+				if( v_pfd[i].revents )
+				{
+					char buf[4096];
+					ssize_t n = read( child.fd, buf, sizeof(buf) );
+					if( n > 0 )
+						child.data.append( buf, n );
+					else if( n == 0 || errno != EINTR )
+					{
+						EndChild( child );
+						std::lock_guard<std::mutex> lock( WatchMutex );
+						MergeQueued( false );
+						munmap( child.watch, sizeof( KUT_WATCH ) );
+						v_child.erase( v_child.begin()+i );
+						continue;
+					}
+				}
+// over its budget, the child process is asked to stop at its next test, and is killed if it does not within KUT_TIMEOUT_GRACE
+				int64_t now = kut_steady_ns();
+				if( !child.expired && ( GlobalExpired || child.watch->Exceeded( now ) ) )
+				{
+					child.expired = now;
+					child.watch->state = 1;
+				}
+				if( child.expired && !child.timed_out && now - child.expired > KUT_TIMEOUT_GRACE*1E9 )
+				{
+					kill( child.pid, SIGKILL );
+					child.timed_out = true;
+				}
+			}
+		}
+#endif
+	}
+
+#ifdef KUT_HAS_FORK
+/// Starts a child process running the unit test \c index of the queue, that sends its results through a pipe
+	KUT_CHILD StartChild( size_t index )
+	{
+		KUT_CHILD child;
+		child.index     = index;
+		child.timed_out = false;
+		child.start     = std::chrono::steady_clock::now();
+		child.expired   = 0;
+		void* p = mmap( 0, sizeof( KUT_WATCH ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+		if( p == MAP_FAILED )
+		{
+			std::cout << "KUT: Unable to map shared memory, exiting..." << ENDL;
+			exit(1);
+		}
+		child.watch = new( p ) KUT_WATCH;
+		child.watch->Start( TestTimeout );
+		int fds[2];
+		if( pipe( fds ) != 0 )
+		{
+			std::cout << "KUT: Unable to create pipe, exiting..." << ENDL;
+			exit(1);
+		}
+		std::cout.flush();
+		kut_logsink.Sync();
+		fflush( 0 );
+		child.pid = fork();
+		if( child.pid == 0 )
+		{
+			close( fds[0] );
+			kut_fork_fd = fds[1];
+			RunTest( v_queue[index], false, child.watch );
+			kut_write_fd( kut_fork_fd, v_queue[index].Encode() );
+			std::cout.flush();
+			_exit(0);
+		}
+		close( fds[1] );
+		if( child.pid < 0 )
+		{
+			std::cout << "KUT: Unable to fork, exiting..." << ENDL;
+			exit(1);
+		}
+		child.fd = fds[0];
+		return child;
+	}
+
+/// Called when the pipe is closed: gets the results, or records the crash (or the timeout) as a failure
+	void EndChild( KUT_CHILD& child )
+	{
+		close( child.fd );
+		int status = 0;
+		while( waitpid( child.pid, &status, 0 ) < 0 && errno == EINTR )
+			;
+		KUT_UNIT_TEST& ut = v_queue[child.index];
+		KUT_UNIT_TEST res( ut );
+		ut.ended = true;
+		if( WIFEXITED( status ) && res.Decode( child.data ) )
+		{
+			ut = res;
+			ut.ended = true;
+			if( ut.result.DoQuit )
+				StopRun = true;
+			return;
+		}
+		std::ostringstream oss;
+		oss << "- ABORTED unit test of " << ut.name << ": ";
+		if( child.timed_out )
+			oss << "killed, over its time budget\n";
+		else if( WIFSIGNALED( status ) )
+			oss << "killed by signal " << WTERMSIG( status ) << " (" << strsignal( WTERMSIG( status ) ) << ")\n";
+		else
+			oss << "exited with code " << WEXITSTATUS( status ) << " without sending its results\n";
+		ut.log         = oss.str();
+		ut.nb_loglines = 1;
+		ut.result      = KUT_TYPE();
+		ut.fail_file.clear();
+		ut.fail_line.clear();
+		if( child.timed_out )
+			ut.AddTimeout( *child.watch );
+		else
+		{
+			ut.result.count_test = 1;
+			ut.result.count_fail = 1;
+			ut.fail_file.assign( 1, ut.name );
+			ut.fail_line.assign( 1, 0 );
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - child.start;
+		ut.timing.wall = elapsed.count();
+	}
+#endif
+
+/// Adds the log output and the counters of a unit test that has been run
+	void MergeResult( const KUT_UNIT_TEST& ut )
+	{
+		kut_ctx->Flush( kut_logsink );
+		kut_logsink.Write( ut.log );
+		kut_ctx->line_counter += ut.nb_loglines;
+		PrintResult( ut, ut.result );
+		Flush();
+		if( ut.hash )
+			m_cache[ut.name] = std::make_pair( ut.hash, ut.result.count_fail == 0 );
+	}
+
+/// Writes the summary to the log file and to stdout, closes the log file and writes the other output files (KUT_MAIN_END, or the watchdog)
+	void PrintSummary()
+	{
+		KUT_LOG << "*****************************************************\n";
+		KUT_LOG << "Test end :";
+		KUT_LOG << " - Nb of U.T. = "        << NbUnitTests  << ENDL;
+		KUT_LOG << " - Nb U.T. Failures = "  << NbUTFailures << ENDL;
+		KUT_LOG << " - Total Nb of tests = " << NbTestTot    << ENDL;
+		KUT_LOG << " - Total Nb failures = " << NbFailureTot << ENDL;
+		if( NbNotSelected )
+			KUT_LOG << " - Nb of U.T. not selected (filter or shard) = " << NbNotSelected << ENDL;
+		if( NbCached )
+			KUT_LOG << " - Nb of U.T. cached (unchanged since they passed) = " << NbCached << ENDL;
+		if( GlobalExpired )
+			KUT_LOG << " - Global time budget of " << GlobalTimeout << " s exceeded" << ENDL;
+		if( NbNotRun )
+			KUT_LOG << " - Nb of U.T. not run (time budget exceeded, or run stopped on failure) = " << NbNotRun << ENDL;
+		if( v_failed_test_name.size() )
+			KUT_LOG << " - List of failed tests:" << ENDL;
+		for( size_t i=0; i<v_failed_test_name.size(); i++ )
+		{
+			KUT_LOG << i << ": test failed for ";
+			if( v_failed_test_type[i]==0 )
+			{
+				KUT_LOG2 << "class";
+			}
+			else
+			{
+				KUT_LOG2 << "function";
+			}
+			KUT_LOG2 << ": " << v_failed_test_name[i];
+			KUT_LOG2 << ", see at line " << v_failed_test_logline[i] << ENDL;
+		}
+		PrintSlowest();
+		Flush();
+		kut_logsink.Close();
+		WriteBaseline();
+		WriteTimings();
+		WriteCache();
+		EndReport();
+		std::cout << "\n Test end :";
+		std::cout << "\n - Nb of U.T. = "        << NbUnitTests;
+		std::cout << "\n - Nb Failures = "       << NbUTFailures;
+		std::cout << "\n - Total Nb of tests = " << NbTestTot;
+		std::cout << "\n - Total Nb failures = " << NbFailureTot << ENDL;
+		if( NbNotSelected )
+			std::cout << " - Nb of U.T. not selected (filter or shard) = " << NbNotSelected << ENDL;
+		if( NbCached )
+			std::cout << " - Nb of U.T. cached (unchanged since they passed) = " << NbCached << ENDL;
+		if( GlobalExpired )
+			std::cout << " - Global time budget of " << GlobalTimeout << " s exceeded" << ENDL;
+		if( NbNotRun )
+			std::cout << " - Nb of U.T. not run (time budget exceeded, or run stopped on failure) = " << NbNotRun << ENDL;
+		std::cout << " See file " << KUT_FILENAME << " file\n";
+	}
+
+/// Writes the log buffer of the main thread to the log file (at each unit test boundary)
+	void Flush()
+	{
+		kut_ctx->Flush( kut_logsink );
+		kut_logsink.Flush();
+	}
+
+	void PrintHeader( const KUT_UNIT_TEST& ut )
+	{
+		NbUnitTests++;
+		KUT_LOG << "*****************************************************\n";
+		kut_ctx->line_counter++;
+		KUT_LOG2 << "* Unit test no " << NbUnitTests << ", testing " << (ut.type==0 ? "class " : "function ") << ut.name << " TEMP " << kut_ctx->line_counter << ENDL;
+	}
+
+	void PrintResult( const KUT_UNIT_TEST& ut, const KUT_TYPE& kut_data )
+	{
+		if( kut_binlog )
+			WriteBinLog( ut, kut_data );
+		if( !RunStarted )
+		{
+			for( size_t i=0; i<v_reporter.size(); i++ )
+				v_reporter[i]->RunStart();
+			RunStarted = true;
+		}
+		for( size_t i=0; i<v_reporter.size(); i++ )
+			v_reporter[i]->TestEnd( NbUnitTests, ut, kut_data );
+		v_timing.push_back( ut.timing );
+		for( size_t i=0; i<ut.v_timing.size(); i++ )
+		{
+			v_timing.push_back( ut.v_timing[i] );
+			v_timing.back().name = ut.name + '/' + ut.v_timing[i].name;
+		}
+		for( size_t i=0; i<kut_data.v_bench.size(); i++ )
+			m_bench_median[ kut_data.v_bench[i].name ] = kut_data.v_bench[i].median;
+		std::cout << NbUnitTests << " : Unit test of " << (ut.type==0 ? "class " : "function ") << ut.name << " : " << kut_data.count_test <<  " tests : ";
+		NbTestTot += kut_data.count_test;
+		if( kut_data.count_fail == 0 )
+			std::cout << " success\n";
+		else
+		{
+			std::cout << kut_data.count_fail << " failure(s)\n";
+			NbFailureTot += kut_data.count_fail;
+			NbUTFailures++;
+			v_failed_test_name.push_back( ut.name );
+			v_failed_test_type.push_back( ut.type );
+			v_failed_test_logline.push_back( kut_ctx->line_counter );
+		}
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// User needs to put this at the beginning of his main test file (global allocation)
+#define KUT_ALLOC \
+	bool                      kut_verbose = KUT_VERBOSE_MODE; \
+	KUT_LOG_SINK              kut_logsink; \
+	KUT_LOG_STREAM            kut_logfile; \
+	KUT_CONTEXT               kut_main_context( 0, true ); \
+	thread_local KUT_CONTEXT* kut_ctx = &kut_main_context; \
+	std::map<std::string,double> kut_baseline; \
+	int                       kut_fork_fd = -1; \
+	bool                      kut_binlog = false; \
+	thread_local KUT_ALLOC_COUNT kut_alloc_count; \
+	KUT_P_ALLOC_HOOKS
+
+#ifdef KUT_TRACK_ALLOC
+/// Private macro: the operator new/delete counting the allocations, defined by KUT_ALLOC (see \ref alloc)
+#define KUT_P_ALLOC_HOOKS \
+	void* operator new( std::size_t n ) \
+	{ \
+		void* p = kut_alloc( n ); \
+		if( !p ) \
+			throw std::bad_alloc(); \
+		return p; \
+	} \
+	void* operator new[]( std::size_t n ) \
+	{ \
+		void* p = kut_alloc( n ); \
+		if( !p ) \
+			throw std::bad_alloc(); \
+		return p; \
+	} \
+	void* operator new( std::size_t n, const std::nothrow_t& ) noexcept   { return kut_alloc( n ); } \
+	void* operator new[]( std::size_t n, const std::nothrow_t& ) noexcept { return kut_alloc( n ); } \
+	void operator delete( void* p ) noexcept                           { kut_free( p ); } \
+	void operator delete[]( void* p ) noexcept                         { kut_free( p ); } \
+	void operator delete( void* p, const std::nothrow_t& ) noexcept    { kut_free( p ); } \
+	void operator delete[]( void* p, const std::nothrow_t& ) noexcept  { kut_free( p ); } \
+	KUT_P_SIZED_DELETE \
+	KUT_P_ALIGNED_NEW \
+	bool kut_alloc_hooked = true
+
+#ifdef __cpp_sized_deallocation
+	#define KUT_P_SIZED_DELETE \
+		void operator delete( void* p, std::size_t ) noexcept   { kut_free( p ); } \
+		void operator delete[]( void* p, std::size_t ) noexcept { kut_free( p ); }
+#else
+	#define KUT_P_SIZED_DELETE
+#endif
+
+#ifdef __cpp_aligned_new
+/// Private macro: the operator new/delete for the over-aligned types (C++17)
+	#define KUT_P_ALIGNED_NEW \
+		void* operator new( std::size_t n, std::align_val_t a ) \
+		{ \
+			void* p = kut_alloc_aligned( n, (std::size_t)a ); \
+			if( !p ) \
+				throw std::bad_alloc(); \
+			return p; \
+		} \
+		void* operator new[]( std::size_t n, std::align_val_t a ) \
+		{ \
+			void* p = kut_alloc_aligned( n, (std::size_t)a ); \
+			if( !p ) \
+				throw std::bad_alloc(); \
+			return p; \
+		} \
+		void* operator new( std::size_t n, std::align_val_t a, const std::nothrow_t& ) noexcept   { return kut_alloc_aligned( n, (std::size_t)a ); } \
+		void* operator new[]( std::size_t n, std::align_val_t a, const std::nothrow_t& ) noexcept { return kut_alloc_aligned( n, (std::size_t)a ); } \
+		void operator delete( void* p, std::align_val_t ) noexcept                            { kut_free_aligned( p ); } \
+		void operator delete[]( void* p, std::align_val_t ) noexcept                          { kut_free_aligned( p ); } \
+		void operator delete( void* p, std::align_val_t, const std::nothrow_t& ) noexcept     { kut_free_aligned( p ); } \
+		void operator delete[]( void* p, std::align_val_t, const std::nothrow_t& ) noexcept   { kut_free_aligned( p ); } \
+		KUT_P_ALIGNED_SIZED_DELETE
+	#ifdef __cpp_sized_deallocation
+		#define KUT_P_ALIGNED_SIZED_DELETE \
+			void operator delete( void* p, std::size_t, std::align_val_t ) noexcept   { kut_free_aligned( p ); } \
+			void operator delete[]( void* p, std::size_t, std::align_val_t ) noexcept { kut_free_aligned( p ); }
+	#else
+		#define KUT_P_ALIGNED_SIZED_DELETE
+	#endif
+#else
+	#define KUT_P_ALIGNED_NEW
+#endif
+#else
+	#define KUT_P_ALLOC_HOOKS bool kut_alloc_hooked = false
+#endif
+
+
+//-------------------------------------------------------------------------------------------
+//-------------------------------------------------------------------------------------------
+/// \name Value printer, writes the values of a failed test in the log file (see \ref macros)
+//@{
+
+/// Compile-time sequence of indexes (std::index_sequence is C++14)
+template<size_t... I>
+struct KUT_INDEX_SEQ
+{};
+
+template<size_t N, size_t... I>
+struct KUT_MAKE_INDEX_SEQ : KUT_MAKE_INDEX_SEQ<N-1, N-1, I...>
+{};
+
+template<size_t... I>
+struct KUT_MAKE_INDEX_SEQ<0, I...>
+{
+	typedef KUT_INDEX_SEQ<I...> type;
+};
+
+/// Priority of the overloads of kut_print_value(): the highest one that compiles for the type is selected
+template<int N>
+struct KUT_RANK : KUT_RANK<N-1>
+{};
+
+template<>
+struct KUT_RANK<0>
+{};
+
+/// true for arrays of \c char (string literals), that are not printed or compared as containers
+template<typename T>
+struct KUT_IS_CHAR_ARRAY : std::integral_constant<bool,
+	std::is_array<T>::value && std::is_same<typename std::remove_cv<typename std::remove_extent<T>::type>::type, char>::value>
+{};
+
+template<typename T>
+void kut_print( std::ostream& os, const T& v );
+
+/// Prints an element of a container or of a tuple: same as kut_print(), but strings are quoted
+template<typename T>
+void kut_print_elem( std::ostream& os, const T& v )
+{
+	kut_print( os, v );
+}
+
+inline void kut_print_elem( std::ostream& os, const std::string& v )
+{
+	os << '"';
+	kut_print( os, v );
+	os << '"';
+}
+
+inline void kut_print_elem( std::ostream& os, const char* v )
+{
+	os << '"';
+	kut_print( os, v );
+	os << '"';
+}
+
+/// Types having a stream operator
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<6> )
+	-> decltype( void( os << v ) )
+{
+	os << v;
+}
+
+/// Types having a member function \c Print(FILE*): its output is read back from a temporary file
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<5> )
+	-> decltype( void( std::declval<T&>().Print( (FILE*)0 ) ) )
+{
+	FILE* f = std::tmpfile();
+	if( !f )
+	{
+		os << "<unable to print>";
+		return;
+	}
+	const_cast<T&>( v ).Print( f );
+	std::rewind( f );
+	std::string s;
+	char buf[256];
+	size_t n;
+	while( ( n = std::fread( buf, 1, sizeof(buf), f ) ) > 0 )
+		s.append( buf, n );
+	std::fclose( f );
+	while( !s.empty() && s[s.size()-1] == '\n' )
+		s.erase( s.size()-1 );
+	os << s;
+}
+
+/// Optional values (\c has_value() and \c operator*, as \c std::optional)
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<4> )
+	-> decltype( void( bool( v.has_value() ) ), void( *v ) )
+{
+	if( v.has_value() )
+	{
+		os << "optional(";
+		kut_print_elem( os, *v );
+		os << ')';
+	}
+	else
+		os << "nullopt";
+}
+
+/// Containers: only the first KUT_PRINT_MAX_ELEMS elements are printed, followed by the size
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<3> )
+	-> decltype( void( std::begin( v ) != std::end( v ) ) )
+{
+	os << '[';
+	size_t i = 0;
+	for( auto it = std::begin( v ); it != std::end( v ); ++it, ++i )
+	{
+		if( i == KUT_PRINT_MAX_ELEMS )
+		{
+			for( ; it != std::end( v ); ++it )
+				i++;
+			os << ", ... (" << i << " elements)";
+			break;
+		}
+		if( i )
+			os << ", ";
+		kut_print_elem( os, *it );
+	}
+	os << ']';
+}
+
+template<typename T, size_t... I>
+void kut_print_tuple( std::ostream& os, const T& v, KUT_INDEX_SEQ<I...> )
+{
+	int dummy[] = { 0, ( os << (I ? ", " : ""), kut_print_elem( os, std::get<I>( v ) ), 0 )... };
+	(void)dummy;
+}
+
+/// Tuples and pairs
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<2> )
+	-> decltype( void( std::tuple_size<T>::value ) )
+{
+	os << '(';
+	kut_print_tuple( os, v, typename KUT_MAKE_INDEX_SEQ<std::tuple_size<T>::value>::type() );
+	os << ')';
+}
+
+/// Enumerations without stream operator (enum class): the underlying value
+template<typename T>
+auto kut_print_value( std::ostream& os, const T& v, KUT_RANK<1> )
+	-> typename std::enable_if<std::is_enum<T>::value>::type
+{
+	os << +static_cast<typename std::underlying_type<T>::type>( v );
+}
+
+/// Anything else: the size and the first bytes of the object
+template<typename T>
+void kut_print_value( std::ostream& os, const T& v, KUT_RANK<0> )
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>( std::addressof( v ) );
+	os << '{' << sizeof(T) << " bytes:";
+	char buf[8];
+	for( size_t i=0; i<sizeof(T) && i<16; i++ )
+	{
+		snprintf( buf, sizeof(buf), " %02x", p[i] );
+		os << buf;
+	}
+	if( sizeof(T) > 16 )
+		os << " ...";
+	os << '}';
+}
+
+/// Prints any value in \c os, with a length limited to KUT_PRINT_MAX_LENGTH
+/**
+The way the value is printed is selected at compile time, see the overloads of kut_print_value().
+*/
+template<typename T>
+void kut_print( std::ostream& os, const T& v )
+{
+	std::ostringstream oss;
+	oss.flags( os.flags() );
+	oss.precision( os.precision() );
+	kut_print_value( oss, v, KUT_RANK<6>() );
+	std::string s = oss.str();
+	if( s.size() > KUT_PRINT_MAX_LENGTH )
+		os << s.substr( 0, KUT_PRINT_MAX_LENGTH ) << "... (" << s.size() << " chars)";
+	else
+		os << s;
+}
+
+/// Writes the first mismatching elements of two containers in the log file (at most KUT_PRINT_MAX_DIFF), and their sizes if they differ
+template<typename T1, typename T2>
+auto kut_log_diff( const T1& a, const T2& b, KUT_RANK<1> )
+	-> typename std::enable_if<!KUT_IS_CHAR_ARRAY<T1>::value && !KUT_IS_CHAR_ARRAY<T2>::value,
+		decltype( void( *std::begin( a ) == *std::begin( b ) ), void( std::end( a ) ), void( std::end( b ) ) )>::type
+{
+	size_t i = 0, nb_diff = 0;
+	auto ia = std::begin( a );
+	auto ib = std::begin( b );
+	for( ; ia != std::end( a ) && ib != std::end( b ); ++ia, ++ib, ++i )
+		if( !( *ia == *ib ) && nb_diff++ < KUT_PRINT_MAX_DIFF )
+		{
+			KUT_LOG << "  -mismatch at index " << i << ": ";
+			kut_print_elem( KUT_LOG2, *ia );
+			KUT_LOG2 << " != ";
+			kut_print_elem( KUT_LOG2, *ib );
+			KUT_LOG2 << ENDL;
+		}
+	if( nb_diff > KUT_PRINT_MAX_DIFF )
+		KUT_LOG << "  -" << nb_diff << " mismatching elements in the first " << i << ENDL;
+	size_t size_a = i, size_b = i;
+	for( ; ia != std::end( a ); ++ia )
+		size_a++;
+	for( ; ib != std::end( b ); ++ib )
+		size_b++;
+	if( size_a != size_b )
+		KUT_LOG << "  -sizes differ: " << size_a << " and " << size_b << ENDL;
+}
+
+/// Values that are not containers: nothing to do
+template<typename T1, typename T2>
+void kut_log_diff( const T1&, const T2&, KUT_RANK<0> )
+{}
+
+///@}
+
+//-------------------------------------------------------------------------------------------
+/// Static description of a test macro, built at compile time: the macro itself only holds a pointer to it
+struct KUT_SITE
+{
+	const char* file;
+	int         line;
+	const char* expr;   ///< expression, as stored in the binary log file
+	int         op;     ///< see KUT_OP
+	const char* text;   ///< end of the log line, written after the result of the test
+	int         style;  ///< 0: \c text is written with KUT_LOG2, 1: with KUT_LOG (counts as a new line)
+	const char* func;   ///< function holding the test
+};
+
+/// Called on failure (see KUT_P_FAILURE): counts it, logs it, and ends the test if requested (see KUT_SET_STOP_ON_FAIL)
+KUT_COLD inline void kut_failure( KUT_TYPE& kut_data, const KUT_SITE* site )
+{
+	kut_data.count_fail++;
+	if( kut_verbose )
+	{
+		KUT_LOG << "FAIL (" << kut_data.count_fail << "), on line ";
+		KUT_LOG2 << site->line << " of file " << site->file;
+	}
+	kut_data.kut_failflag = true;
+	kut_ctx->fail_file.push_back( site->file );
+	kut_ctx->fail_line.push_back( site->line );
+	if( kut_data.StopTestOnFail )
+	{
+		std::cout << " -premature ending of test !\n";
+		kut_data.DoQuit = true;
+		KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n";
+		KUT_LOG << " - in function : " << site->func << ENDL;
+		KUT_LOG << " - Actual status : " << kut_data.count_test << " tests done and " << kut_data.count_fail << " failure(s)\n\n";
+		kut_premature_end( kut_data );
+	}
+}
+
+/// Single out-of-line handler of the test macros: writes the end of the log line and the binary log record
+/**
+Only called when something has to be written (failure, verbose mode, or binary log), so the inlined code of a test macro
+is the comparison, the counters, and one test-and-branch.
+In fast mode (see \ref fastmode), only called on failure, and writes a single line.
+*/
+KUT_COLD inline void kut_report( KUT_TYPE& kut_data, const KUT_SITE* site, bool pass )
+{
+#ifdef KUT_FAST_MODE
+	(void)pass;
+	kut_data.count_fail++;
+	kut_ctx->fail_file.push_back( site->file );
+	kut_ctx->fail_line.push_back( site->line );
+	KUT_LOG << " * Test " << kut_data.count_test << ": FAIL (" << kut_data.count_fail << "), on line " << site->line
+		<< " of file " << site->file << ", expression: " << site->expr << ENDL;
+	if( kut_binlog )
+		kut_ctx->AddRecord( site->file, site->line, site->expr, site->op, false, kut_data.count_test );
+	if( kut_data.StopTestOnFail )
+	{
+		std::cout << " -premature ending of test !\n";
+		kut_data.DoQuit = true;
+		KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n";
+		KUT_LOG << " - Actual status : " << kut_data.count_test << " tests done and " << kut_data.count_fail << " failure(s)\n\n";
+		kut_premature_end( kut_data );
+	}
+#else
+	if( pass )
+	{
+		if( kut_verbose )
+			KUT_LOG2 << "PASS";
+	}
+	else
+		kut_failure( kut_data, site );
+	if( kut_verbose )
+	{
+		if( site->style )
+			KUT_LOG << site->text << ENDL;
+		else
+			KUT_LOG2 << site->text << ENDL;
+	}
+	if( kut_binlog )
+		kut_ctx->AddRecord( site->file, site->line, site->expr, site->op, pass, kut_data.count_test );
+#endif
+}
+
+/// Writes the beginning of the log line of a test, see kut_begin()
+KUT_COLD inline void kut_log_header( KUT_TYPE& kut_data, int line )
+{
+	KUT_LOG << std::dec << " * Test " << kut_data.count_test << " (" << kut_data.count_test1 << "." << kut_data.count_test2 << "), line: " << line << ": ";
+}
+
+/// Called by kut_begin() when the watchdog has stopped the unit test, because its time budget is exceeded (see \ref watchdog)
+/**
+In a child process (see \ref forked), the results are sent to the parent process, with the timeout as a failure, and the process ends.
+Otherwise the thread stops there for good, so the watchdog thread can read its results before ending the test application.
+*/
+KUT_COLD inline void kut_watch_expired( const KUT_TYPE& kut_data )
+{
+	KUT_WATCH& w = *kut_data.watch;
+	w.stop = kut_steady_ns();
+#ifdef KUT_HAS_FORK
+	if( kut_fork_fd >= 0 )
+	{
+		KUT_UNIT_TEST ut( "", 0, 0 );
+		ut.SetResult( kut_data, *kut_data.ctx, 0 );
+		ut.timing.wall = ( w.stop - w.start.load() ) * 1E-9;
+		ut.AddTimeout( w );
+		kut_write_fd( kut_fork_fd, ut.Encode() );
+		std::cout.flush();
+		_exit(1);
+	}
+#endif
+	w.data = &kut_data;
+	w.state.store( 2, std::memory_order_release );
+	for( ;; )
+		std::this_thread::sleep_for( std::chrono::seconds( 1 ) );
+}
+
+/// Called by a test macro to start a test: counts it and, in verbose mode, writes the beginning of the log line
+/**
+Also records the location of the test for the watchdog, and stops there if the time budget of the unit test is exceeded.
+In fast mode (see \ref fastmode), it only counts the test: the budget is checked when the unit test ends.
+*/
+inline void kut_begin( KUT_TYPE& kut_data, const char* file, int line )
+{
+	kut_data.count_test++;
+#ifdef KUT_FAST_MODE
+	(void)file;
+	(void)line;
+#else
+	KUT_WATCH& w = *kut_data.watch;
+	if( w.state.load( std::memory_order_relaxed ) != 0 )
+		kut_watch_expired( kut_data );
+	w.line.store( line, std::memory_order_relaxed );
+	w.file.store( file, std::memory_order_relaxed );
+	kut_data.count_test2++;
+	if( kut_verbose )
+		kut_log_header( kut_data, line );
+#endif
+	kut_data.kut_failflag = false;
+}
+
+/// Called by a test macro to end a test, with its result
+inline void kut_end( KUT_TYPE& kut_data, const KUT_SITE* site, bool pass )
+{
+	kut_data.kut_failflag = !pass;
+#ifdef KUT_FAST_MODE
+	if( !pass )
+#else
+	if( !pass || kut_verbose || kut_binlog )
+#endif
+		kut_report( kut_data, site, pass );
+}
+
+/// Writes a line in the log file, used by the test macros on failure
+KUT_COLD inline void kut_log_line( const char* text )
+{
+	KUT_LOG << text << ENDL;
+}
+
+/// Writes a value in the log file, after \c text, used by the test macros on failure
+template<typename T>
+KUT_COLD void kut_log_value( const char* text, const T& value )
+{
+	KUT_LOG << text;
+	kut_print( KUT_LOG2, value );
+	KUT_LOG2 << ENDL;
+}
+
+/// Writes the two values of a failed comparison in the log file and, for containers, their first mismatching elements, see KUT_P_STREAM_VALUES
+template<typename T1, typename T2>
+KUT_COLD void kut_log_values( const char* expr_a, const char* expr_b, const T1& a, const T2& b )
+{
+	KUT_LOG << "  -first value : \"" << expr_a << "\" = \"";
+	kut_print( KUT_LOG2, a );
+	KUT_LOG2 << "\"" << ENDL;
+	KUT_LOG << "  -second value: \"" << expr_b << "\" = \"";
+	kut_print( KUT_LOG2, b );
+	KUT_LOG2 << "\"" << ENDL;
+	kut_log_diff( a, b, KUT_RANK<1>() );
+}
+
+//-------------------------------------------------------------------------------------------
+/// \name Range comparisons, see KUT_EQ_RANGE
+//@{
+
+/// Vectorized comparisons of the elements of type \c T, \c width is 0 if there are none (see KUT_SIMD_SSE2 and KUT_SIMD_AVX2)
+/**
+\c eq(), \c lt() and \c le() return a mask with one bit per element, set if the comparison is true.
+*/
+template<typename T>
+struct KUT_SIMD
+{
+	enum { width = 0 };
+};
+
+#if defined(KUT_SIMD_AVX2)
+template<>
+struct KUT_SIMD<unsigned char>
+{
+	typedef __m256i reg;
+	enum { width = 32 };
+	static unsigned all() { return 0xFFFFFFFFu; }
+	static reg load( const unsigned char* p ) { return _mm256_loadu_si256( (const __m256i*)p ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm256_movemask_epi8( _mm256_cmpeq_epi8( a, b ) ); }
+};
+
+template<>
+struct KUT_SIMD<float>
+{
+	typedef __m256 reg;
+	enum { width = 8 };
+	static unsigned all() { return 0xFFu; }
+	static reg load( const float* p ) { return _mm256_loadu_ps( p ); }
+	static reg set( float v ) { return _mm256_set1_ps( v ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_EQ_OQ ) ); }
+	static void store( float* p, reg a ) { _mm256_storeu_ps( p, a ); }
+	static reg sub( reg a, reg b ) { return _mm256_sub_ps( a, b ); }
+	static reg mul( reg a, reg b ) { return _mm256_mul_ps( a, b ); }
+	static reg div( reg a, reg b ) { return _mm256_div_ps( a, b ); }
+	static reg max( reg a, reg b ) { return _mm256_max_ps( a, b ); }
+	static reg abs( reg a ) { return _mm256_andnot_ps( _mm256_set1_ps( -0.f ), a ); }
+	static unsigned lt( reg a, reg b ) { return (unsigned)_mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_LT_OQ ) ); }
+	static unsigned le( reg a, reg b ) { return (unsigned)_mm256_movemask_ps( _mm256_cmp_ps( a, b, _CMP_LE_OQ ) ); }
+};
+
+template<>
+struct KUT_SIMD<double>
+{
+	typedef __m256d reg;
+	enum { width = 4 };
+	static unsigned all() { return 0xFu; }
+	static reg load( const double* p ) { return _mm256_loadu_pd( p ); }
+	static reg set( double v ) { return _mm256_set1_pd( v ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm256_movemask_pd( _mm256_cmp_pd( a, b, _CMP_EQ_OQ ) ); }
+	static void store( double* p, reg a ) { _mm256_storeu_pd( p, a ); }
+	static reg sub( reg a, reg b ) { return _mm256_sub_pd( a, b ); }
+	static reg mul( reg a, reg b ) { return _mm256_mul_pd( a, b ); }
+	static reg div( reg a, reg b ) { return _mm256_div_pd( a, b ); }
+	static reg max( reg a, reg b ) { return _mm256_max_pd( a, b ); }
+	static reg abs( reg a ) { return _mm256_andnot_pd( _mm256_set1_pd( -0. ), a ); }
+	static unsigned lt( reg a, reg b ) { return (unsigned)_mm256_movemask_pd( _mm256_cmp_pd( a, b, _CMP_LT_OQ ) ); }
+	static unsigned le( reg a, reg b ) { return (unsigned)_mm256_movemask_pd( _mm256_cmp_pd( a, b, _CMP_LE_OQ ) ); }
+};
+
+#elif defined(KUT_SIMD_SSE2)
+template<>
+struct KUT_SIMD<unsigned char>
+{
+	typedef __m128i reg;
+	enum { width = 16 };
+	static unsigned all() { return 0xFFFFu; }
+	static reg load( const unsigned char* p ) { return _mm_loadu_si128( (const __m128i*)p ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) ); }
+};
+
+template<>
+struct KUT_SIMD<float>
+{
+	typedef __m128 reg;
+	enum { width = 4 };
+	static unsigned all() { return 0xFu; }
+	static reg load( const float* p ) { return _mm_loadu_ps( p ); }
+	static reg set( float v ) { return _mm_set1_ps( v ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm_movemask_ps( _mm_cmpeq_ps( a, b ) ); }
+	static void store( float* p, reg a ) { _mm_storeu_ps( p, a ); }
+	static reg sub( reg a, reg b ) { return _mm_sub_ps( a, b ); }
+	static reg mul( reg a, reg b ) { return _mm_mul_ps( a, b ); }
+	static reg div( reg a, reg b ) { return _mm_div_ps( a, b ); }
+	static reg max( reg a, reg b ) { return _mm_max_ps( a, b ); }
+	static reg abs( reg a ) { return _mm_andnot_ps( _mm_set1_ps( -0.f ), a ); }
+	static unsigned lt( reg a, reg b ) { return (unsigned)_mm_movemask_ps( _mm_cmplt_ps( a, b ) ); }
+	static unsigned le( reg a, reg b ) { return (unsigned)_mm_movemask_ps( _mm_cmple_ps( a, b ) ); }
+};
+
+template<>
+struct KUT_SIMD<double>
+{
+	typedef __m128d reg;
+	enum { width = 2 };
+	static unsigned all() { return 0x3u; }
+	static reg load( const double* p ) { return _mm_loadu_pd( p ); }
+	static reg set( double v ) { return _mm_set1_pd( v ); }
+	static unsigned eq( reg a, reg b ) { return (unsigned)_mm_movemask_pd( _mm_cmpeq_pd( a, b ) ); }
+	static void store( double* p, reg a ) { _mm_storeu_pd( p, a ); }
+	static reg sub( reg a, reg b ) { return _mm_sub_pd( a, b ); }
+	static reg mul( reg a, reg b ) { return _mm_mul_pd( a, b ); }
+	static reg div( reg a, reg b ) { return _mm_div_pd( a, b ); }
+	static reg max( reg a, reg b ) { return _mm_max_pd( a, b ); }
+	static reg abs( reg a ) { return _mm_andnot_pd( _mm_set1_pd( -0. ), a ); }
+	static unsigned lt( reg a, reg b ) { return (unsigned)_mm_movemask_pd( _mm_cmplt_pd( a, b ) ); }
+	static unsigned le( reg a, reg b ) { return (unsigned)_mm_movemask_pd( _mm_cmple_pd( a, b ) ); }
+};
+#endif
+
+/// Index of the lowest bit set in \c m (not null)
+inline unsigned kut_ctz( unsigned m )
+{
+#if defined(__GNUC__)
+	return __builtin_ctz( m );
+#else
+	unsigned i = 0;
+	for( ; !( m & 1 ); m >>= 1 )
+		i++;
+	return i;
+#endif
+}
+
+/// Index of the first element in [i,n[ such that a[i] != b[i] (n if none): scalar version
+template<typename T>
+size_t kut_mismatch_eq( const T* a, const T* b, size_t i, size_t n, std::integral_constant<int,0> )
+{
+	for( ; i<n; i++ )
+		if( !( a[i] == b[i] ) )
+			return i;
+	return n;
+}
+
+/// Vectorized version, for \c float and \c double
+template<typename T>
+size_t kut_mismatch_eq( const T* a, const T* b, size_t i, size_t n, std::integral_constant<int,1> )
+{
+	typedef KUT_SIMD<T> S;
+	for( ; i + S::width <= n; i += S::width )
+	{
+		unsigned m = S::eq( S::load( a+i ), S::load( b+i ) );
+		if( m != S::all() )
+			return i + kut_ctz( ~m );
+	}
+	return kut_mismatch_eq( a, b, i, n, std::integral_constant<int,0>() );
+}
+
+/// Vectorized version, for the types that are equal if their bytes are equal (integers, enumerations, pointers)
+template<typename T>
+size_t kut_mismatch_eq( const T* a, const T* b, size_t i, size_t n, std::integral_constant<int,2> )
+{
+	const unsigned char* pa = reinterpret_cast<const unsigned char*>( a );
+	const unsigned char* pb = reinterpret_cast<const unsigned char*>( b );
+	size_t j = kut_mismatch_eq( pa, pb, i*sizeof(T), n*sizeof(T), std::integral_constant<int, KUT_SIMD<unsigned char>::width != 0 ? 1 : 0>() );
+	return j / sizeof(T);
+}
+
+/// Index of the first element in [i,n[ such that a[i] != b[i] (n if none), the fastest available version being selected at compile time
+template<typename T>
+size_t kut_mismatch_eq( const T* a, const T* b, size_t i, size_t n )
+{
+	return kut_mismatch_eq( a, b, i, n, std::integral_constant<int,
+		std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value ? 2 : ( KUT_SIMD<T>::width != 0 ? 1 : 0 )>() );
+}
+
+/// Position of a floating-point value in the ordered set of the representable values (the same for -0 and +0)
+inline int64_t kut_ulp_order( double v )
+{
+	int64_t i;
+	std::memcpy( &i, &v, sizeof(i) );
+	return i < 0 ? INT64_MIN - i : i;
+}
+
+inline int64_t kut_ulp_order( float v )
+{
+	int32_t i;
+	std::memcpy( &i, &v, sizeof(i) );
+	return i < 0 ? INT32_MIN - i : i;
+}
+
+/// Distance between two floating-point values, in units in the last place (ULP), the largest value if one of them is NaN
+template<typename T>
+uint64_t kut_ulp_distance( T a, T b )
+{
+	if( a != a || b != b )
+		return UINT64_MAX;
+	int64_t ia = kut_ulp_order( a );
+	int64_t ib = kut_ulp_order( b );
+	return ia > ib ? (uint64_t)ia - (uint64_t)ib : (uint64_t)ib - (uint64_t)ia;
+}
+
+/// Compares two floating-point values with the tolerance \c tol (see KUT_TOL) and, if \c st is not null, updates the largest errors
+template<typename T>
+bool kut_fp_near( T a, T b, const KUT_TOL& tol, KUT_FP_STAT* st )
+{
+	T d = std::fabs( a - b );
+	T m = std::max( std::fabs( a ), std::fabs( b ) );
+	bool pass = ( a == b || d < tol.abs || d <= tol.rel * m );
+	if( st )
+	{
+		st->nb++;
+		if( d > st->max_abs )
+			st->max_abs = d;
+		if( m > 0 && d / m > st->max_rel )
+			st->max_rel = d / m;
+		if( st->has_ulp )
+		{
+			uint64_t u = kut_ulp_distance( a, b );
+			if( u != UINT64_MAX && u > st->max_ulp )
+				st->max_ulp = u;
+			return pass || u <= tol.ulp;
+		}
+	}
+	return pass || ( tol.ulp && kut_ulp_distance( a, b ) <= tol.ulp );
+}
+
+/// Index of the first element in [i,n[ that is not equal to the other one with the tolerance \c tol (n if none): scalar version
+template<typename T>
+size_t kut_mismatch_tol( const T* a, const T* b, size_t i, size_t n, const KUT_TOL& tol, KUT_FP_STAT* st, std::false_type )
+{
+	for( ; i<n; i++ )
+		if( !kut_fp_near( a[i], b[i], tol, st ) )
+			return i;
+	return n;
+}
+
+/// Vectorized version: the absolute and relative conditions (and the largest errors) are computed with SIMD instructions,
+/// the ULP distance is only checked with the scalar code, for the elements that fail the other conditions
+template<typename T>
+size_t kut_mismatch_tol( const T* a, const T* b, size_t i, size_t n, const KUT_TOL& tol, KUT_FP_STAT* st, std::true_type )
+{
+	typedef KUT_SIMD<T> S;
+	typedef typename S::reg R;
+	const R vabs = S::set( (T)tol.abs );
+	const R vrel = S::set( (T)tol.rel );
+	R max_abs = S::set( 0 );
+	R max_rel = S::set( 0 );
+	size_t nb = 0;
+	auto add_stat = [&]()
+	{
+		T v_abs[S::width], v_rel[S::width];
+		S::store( v_abs, max_abs );
+		S::store( v_rel, max_rel );
+		for( int k=0; k<S::width; k++ )
+		{
+			st->max_abs = std::max( st->max_abs, (double)v_abs[k] );
+			st->max_rel = std::max( st->max_rel, (double)v_rel[k] );
+		}
+		st->nb += nb;
+	};
+	for( ; i + S::width <= n; i += S::width )
+	{
+		R va = S::load( a+i );
+		R vb = S::load( b+i );
+		R d = S::abs( S::sub( va, vb ) );
+		R m = S::max( S::abs( va ), S::abs( vb ) );
+		unsigned ok = S::eq( va, vb ) | S::lt( d, vabs ) | S::le( d, S::mul( vrel, m ) );
+		if( ok == S::all() )
+		{
+			if( st )
+			{
+				max_abs = S::max( d, max_abs );             // NaN values are ignored
+				max_rel = S::max( S::div( d, m ), max_rel );
+				nb += S::width;
+			}
+		}
+		else
+		{
+			size_t j = kut_mismatch_tol( a, b, i, i + S::width, tol, st, std::false_type() );
+			if( j < i + S::width )
+			{
+				if( st )
+					add_stat();
+				return j;
+			}
+		}
+	}
+	if( st )
+		add_stat();
+	return kut_mismatch_tol( a, b, i, n, tol, st, std::false_type() );
+}
+
+/// Index of the first element in [i,n[ that is not equal to the other one with the tolerance \c tol (n if none)
+template<typename T>
+size_t kut_mismatch_tol( const T* a, const T* b, size_t i, size_t n, const KUT_TOL& tol, KUT_FP_STAT* st )
+{
+	return kut_mismatch_tol( a, b, i, n, tol, st, std::integral_constant<bool, KUT_SIMD<T>::width != 0>() );
+}
+
+/// Pointer to the elements of a contiguous range (a container with a \c data() member function, or an array)
+template<typename C>
+auto kut_range_data( const C& c ) -> decltype( c.data() )
+{
+	return c.data();
+}
+
+template<typename T, size_t N>
+const T* kut_range_data( const T (&c)[N] )
+{
+	return c;
+}
+
+/// Number of elements of a contiguous range
+template<typename C>
+auto kut_range_size( const C& c ) -> decltype( size_t( c.size() ) )
+{
+	return c.size();
+}
+
+template<typename T, size_t N>
+size_t kut_range_size( const T (&)[N] )
+{
+	return N;
+}
+
+/// Writes the mismatching elements of two ranges in the log file: the first KUT_RANGE_MAX_REPORT ones and,
+/// in "RangeCountAll" mode, their number (see KUT_RANGE_COUNT_ALL)
+/**
+\c mismatch( i, n ) returns the index of the first mismatching element in [i,n[, or n.
+*/
+template<typename T, typename M>
+KUT_COLD void kut_range_report( KUT_TYPE& kut_data, const T* a, size_t na, const T* b, size_t nb, size_t first, M mismatch )
+{
+	size_t n = std::min( na, nb );
+	if( na != nb )
+		KUT_LOG << "  -sizes differ: " << na << " and " << nb << ENDL;
+	std::streamsize prec = KUT_LOG2.precision();
+	if( std::is_floating_point<T>::value )
+		KUT_LOG2.precision( std::numeric_limits<T>::max_digits10 );
+	size_t nb_diff = 0;
+	for( size_t i=first; i<n; i = mismatch( i+1, n ) )
+	{
+		if( nb_diff++ < KUT_RANGE_MAX_REPORT )
+		{
+			KUT_LOG << "  -mismatch at index " << i << ": ";
+			kut_print_elem( KUT_LOG2, a[i] );
+			KUT_LOG2 << " != ";
+			kut_print_elem( KUT_LOG2, b[i] );
+			KUT_LOG2 << ENDL;
+		}
+		else if( !kut_data.RangeCountAll )
+		{
+			KUT_LOG << "  -more than " << KUT_RANGE_MAX_REPORT << " mismatching elements" << ENDL;
+			break;
+		}
+	}
+	KUT_LOG2.precision( prec );
+	if( kut_data.RangeCountAll && nb_diff )
+		KUT_LOG << "  -" << nb_diff << " mismatching elements out of " << n << " (" << 100. * nb_diff / n << " %)" << ENDL;
+}
+
+/// Element type of a contiguous range
+template<typename C>
+struct KUT_RANGE_ELEM
+{
+	typedef typename std::remove_cv<typename std::remove_pointer<decltype( kut_range_data( std::declval<const C&>() ) )>::type>::type type;
+};
+
+/// Compares two contiguous ranges with their == operator, see KUT_EQ_RANGE
+template<typename A, typename B>
+void kut_range_eq( KUT_TYPE& kut_data, const KUT_SITE* site, const A& ra, const B& rb )
+{
+	typedef typename KUT_RANGE_ELEM<A>::type T;
+	static_assert( std::is_same<T, typename KUT_RANGE_ELEM<B>::type>::value, "KUT_EQ_RANGE: the two ranges must hold the same type of elements" );
+	const T* a = kut_range_data( ra );
+	const T* b = kut_range_data( rb );
+	size_t na = kut_range_size( ra ), nb = kut_range_size( rb );
+	size_t n = std::min( na, nb );
+	size_t first = kut_mismatch_eq( a, b, 0, n );
+	bool pass = ( first == n && na == nb );
+	kut_end( kut_data, site, pass );
+	if( !pass && kut_verbose )
+		kut_range_report( kut_data, a, na, b, nb, first,
+			[a,b]( size_t i, size_t end ){ return kut_mismatch_eq( a, b, i, end ); } );
+}
+
+/// Compares two contiguous ranges of floating-point values, with the tolerance \c tol, see KUT_EQ_RANGE_TOL
+template<typename A, typename B>
+void kut_range_near( KUT_TYPE& kut_data, const KUT_SITE* site, const A& ra, const B& rb, const KUT_TOL& tol )
+{
+	typedef typename KUT_RANGE_ELEM<A>::type T;
+	static_assert( std::is_same<T, typename KUT_RANGE_ELEM<B>::type>::value, "KUT_EQ_RANGE_TOL: the two ranges must hold the same type of elements" );
+	static_assert( std::is_same<T, float>::value || std::is_same<T, double>::value, "KUT_EQ_RANGE_TOL: the ranges must hold float or double values" );
+	const T* a = kut_range_data( ra );
+	const T* b = kut_range_data( rb );
+	size_t na = kut_range_size( ra ), nb = kut_range_size( rb );
+	size_t n = std::min( na, nb );
+	size_t first = kut_mismatch_tol( a, b, 0, n, tol, kut_verbose ? kut_ctx->FpStat( site, tol, false ) : 0 );
+	bool pass = ( first == n && na == nb );
+	kut_end( kut_data, site, pass );
+	if( !pass && kut_verbose )
+		kut_range_report( kut_data, a, na, b, nb, first,
+			[a,b,&tol]( size_t i, size_t end ){ return kut_mismatch_tol( a, b, i, end, tol, 0 ); } );
+}
+
+inline KUT_FP_STAT* KUT_CONTEXT::FpStat( const KUT_SITE* site, const KUT_TOL& tol, bool has_ulp )
+{
+	std::map<const KUT_SITE*,KUT_FP_STAT>::iterator it = m_fp_stat.find( site );
+	if( it == m_fp_stat.end() )
+	{
+		KUT_FP_STAT st = { site->file, site->line, 0, 0., 0., 0, has_ulp, tol };
+		it = m_fp_stat.insert( std::make_pair( site, st ) ).first;
+	}
+	it->second.tol = tol;
+	return &it->second;
+}
+
+/// Compares two values with the tolerance \c tol (see KUT_EQ_F and KUT_EQ_TOL): with \c float if both are \c float, else with \c double.
+/// The largest errors are measured in verbose mode.
+template<typename A, typename B>
+auto kut_fp_eq( const KUT_SITE* site, const A& a, const B& b, const KUT_TOL& tol )
+	-> typename std::enable_if<std::is_arithmetic<A>::value && std::is_arithmetic<B>::value, bool>::type
+{
+	typedef typename std::conditional<std::is_same<A,float>::value && std::is_same<B,float>::value, float, double>::type T;
+	return kut_fp_near( T( a ), T( b ), tol, kut_verbose ? kut_ctx->FpStat( site, tol, true ) : 0 );
+}
+
+/// Other types: they need the '-' operator, returning a floating-point value, only the absolute tolerance is used
+template<typename A, typename B>
+auto kut_fp_eq( const KUT_SITE*, const A& a, const B& b, const KUT_TOL& tol )
+	-> typename std::enable_if<!std::is_arithmetic<A>::value || !std::is_arithmetic<B>::value, bool>::type
+{
+	return std::fabs( a - b ) < tol.abs;
+}
+
+/// Writes the errors of a failed floating-point comparison in the log file
+template<typename A, typename B>
+KUT_COLD auto kut_fp_report( const A& a, const B& b )
+	-> typename std::enable_if<std::is_arithmetic<A>::value && std::is_arithmetic<B>::value>::type
+{
+	typedef typename std::conditional<std::is_same<A,float>::value && std::is_same<B,float>::value, float, double>::type T;
+	T d = std::fabs( T( a ) - T( b ) );
+	T m = std::max( std::fabs( T( a ) ), std::fabs( T( b ) ) );
+	KUT_LOG << "  -error: abs: " << d << ", rel: " << ( m > 0 ? d / m : T( 0 ) ) << ", ulp: " << kut_ulp_distance( T( a ), T( b ) ) << ENDL;
+}
+
+template<typename A, typename B>
+auto kut_fp_report( const A&, const B& )
+	-> typename std::enable_if<!std::is_arithmetic<A>::value || !std::is_arithmetic<B>::value>::type
+{}
+
+//-------------------------------------------------------------------------------------------
+/// Block of code whose allocations are checked when it ends, see KUT_ALLOC_SCOPE_MAX and KUT_NO_LEAK
+/**
+Used as the variable of a \c for loop running once: Next() returns true the first time, and does the test the second time.
+*/
+struct KUT_ALLOC_SCOPE
+{
+	KUT_TYPE&      data;
+	KUT_SITE       site;
+	int64_t        max;  ///< maximum nb of allocations, or -1 for KUT_NO_LEAK
+	KUT_ALLOC_MARK mark;
+	bool           done;
+
+	KUT_ALLOC_SCOPE( KUT_TYPE& kut_data, const char* file, int line, const char* expr, const char* text, const char* func, int64_t n )
+		: data( kut_data ), max( n ), done( false )
+	{
+		KUT_SITE s = { file, line, expr, KUT_OP_ALLOC, text, 0, func };
+		site = s;
+	}
+	bool Next()
+	{
+		if( !done )
+			return done = true;
+		KUT_ALLOC_COUNT a = mark.Stop();
+		if( !kut_alloc_hooked )
+			return false;
+		kut_begin( data, site.file, site.line );
+		bool pass = ( max < 0 ? a.cur <= 0 : a.nb_alloc <= max );
+		kut_end( data, &site, pass );
+		if( !pass && kut_verbose )
+			KUT_LOG << "  -allocations: " << a.nb_alloc << ", deallocations: " << a.nb_free << ", bytes: " << a.bytes
+				<< ", peak: " << a.peak << " bytes, not freed: " << a.cur << " bytes" << ENDL;
+		return false;
+	}
+};
+
+//-------------------------------------------------------------------------------------------
+/// Lifetime of a fixture, see KUT_FIXTURE_TRAITS
+enum KUT_FIXTURE_SCOPE
+{
+	KUT_FIXTURE_TEST,   ///< built for each unit test, and destroyed at its end (default)
+	KUT_FIXTURE_THREAD, ///< built once per thread running unit tests, and reset before each other unit test using it
+	KUT_FIXTURE_SUITE   ///< built once per test program, and reset before each other unit test using it
+};
+
+/// Default construction and reset of a fixture, to derive from when specializing KUT_FIXTURE_TRAITS
+template<typename F>
+struct KUT_FIXTURE_BASE
+{
+	enum { scope = KUT_FIXTURE_TEST };
+	static F* Create() { return new F(); }
+	static void Reset( F& ) {}
+};
+
+/// How a fixture, or a tested class, of type \c F is built, kept and reset. Specialize it for your types (see \ref fixtures)
+template<typename F>
+struct KUT_FIXTURE_TRAITS : KUT_FIXTURE_BASE<F>
+{};
+
+/// Returns the pooled fixture held by \c obj, building it on first use, or resetting it
+template<typename F>
+F* kut_fixture_take( std::unique_ptr<F>& obj )
+{
+	if( !obj )
+		obj.reset( KUT_FIXTURE_TRAITS<F>::Create() );
+	else
+		KUT_FIXTURE_TRAITS<F>::Reset( *obj );
+	return obj.get();
+}
+
+/// Returns the fixture of type \c F of the current unit test, according to its scope (see KUT_FIXTURE)
+/**
+The fixtures handed to a unit test are recorded in its context, so it always gets the same one, and the pooled ones are reset once per unit test.
+The suite fixtures are locked until the unit test ends (see KUT_CONTEXT::ReleaseFixtures()), so the unit tests using them run one at a time.
+*/
+template<typename F>
+F& kut_fixture()
+{
+	typedef KUT_FIXTURE_TRAITS<F> T;
+	static const char key = 0;
+	KUT_CONTEXT& ctx = *kut_ctx->owner;
+	std::lock_guard<std::recursive_mutex> lock( ctx.fixture_mutex );
+	for( size_t i=0; i<ctx.v_fixture.size(); i++ )
+		if( ctx.v_fixture[i].first == &key )
+			return *static_cast<F*>( ctx.v_fixture[i].second.get() );
+
+	std::shared_ptr<void> p;
+	if( int( T::scope ) == KUT_FIXTURE_THREAD )
+	{
+		static thread_local std::unique_ptr<F> obj;
+		p = std::shared_ptr<void>( kut_fixture_take( obj ), []( void* ){} );
+	}
+	else if( int( T::scope ) == KUT_FIXTURE_SUITE )
+	{
+		static std::unique_ptr<F> obj;
+		bool take = !ctx.suite_locked;
+		if( take )
+		{
+			kut_suite_lock().Take();
+			ctx.suite_locked = true;
+		}
+		p = std::shared_ptr<void>( kut_fixture_take( obj ), []( void* ){} );
+		if( take && &ctx == &kut_main_context )   // outside of a unit test, the lock is only held while getting the fixture
+		{
+			ctx.suite_locked = false;
+			kut_suite_lock().Release();
+		}
+	}
+	else
+		p = std::shared_ptr<F>( T::Create() );
+	ctx.v_fixture.push_back( std::make_pair( &key, p ) );
+	return *static_cast<F*>( p.get() );
+}
+
+/// Runs the test method of the class \c A, on an instance given by KUT_FIXTURE_TRAITS (see KUT_TEST_CLASS)
+template<typename A>
+KUT_TYPE kut_class_test()
+{
+	if( int( KUT_FIXTURE_TRAITS<A>::scope ) != KUT_FIXTURE_TEST )
+		return kut_fixture<A>().KUT_CUTM();
+	std::unique_ptr<A> a( KUT_FIXTURE_TRAITS<A>::Create() );
+	return a->KUT_CUTM();
+}
+
+///@}
+
+//-------------------------------------------------------------------------------------------
+/// \name Private macros, do not use in your code
+//@{
+
+/// Private macro: declares the static description of the test, see KUT_SITE
+#define KUT_P_SITE( op, expr, text, style ) \
+	static const KUT_SITE kut_site = { __FILE__, __LINE__, expr, op, text, style, __PRETTY_FUNCTION__ }
+
+/// Private macro: the whole code of a test, the condition being evaluated between kut_begin() and kut_end()
+#define KUT_P_TEST( cond, op, expr, text, style ) \
+	{ \
+		KUT_P_SITE( op, expr, text, style ); \
+		kut_begin( kut_data, __FILE__, __LINE__ ); \
+		kut_end( kut_data, &kut_site, bool( cond ) ); \
+	}
+
+/// Private macro
+#define KUT_P_FAILURE \
+	{ \
+		KUT_P_SITE( KUT_OP_TRUE, "", "", 0 ); \
+		kut_failure( kut_data, &kut_site ); \
+	}
+
+/// Common code, to do right after the test
+#define KUT_P11 \
+		{ \
+			if( kut_verbose ) \
+				KUT_LOG2 << "PASS"; \
+		} \
+		else \
+		{ \
+			KUT_P_FAILURE \
+		} \
+
+/// prepare test
+#define KUT_P2 kut_begin( kut_data, __FILE__, __LINE__ )
+
+#ifdef KUT_FAST_MODE
+	#define KUT_P_STREAM_VALUES( a, b )
+#else
+/// streams value of the 2 arguments to log file, if test failed
+	#define KUT_P_STREAM_VALUES( a, b ) \
+		if( kut_data.kut_failflag && kut_verbose ) \
+			kut_log_values( #a, #b, (a), (b) )
+#endif
+
+/// Private macro for comparing (== operator)
+#define KUT_P_EQ( a, b )   KUT_P_TEST( (a) == (b), KUT_OP_EQ, #a " == " #b, ", expression: " #a " == " #b, 0 )
+
+/// Private macro for difference operator
+#define KUT_P_DIFF( a, b ) KUT_P_TEST( (a) != (b), KUT_OP_DIFF, #a " != " #b, ", expression: " #a " != " #b, 0 )
+
+/// Private macro for comparing (< operator)
+#define KUT_P_LESS( a, b ) KUT_P_TEST( (a) < (b), KUT_OP_LESS, #a " < " #b, ", expression: " #a " < " #b, 0 )
+
+/// Private macro for 'true' test
+#define KUT_P_TRUE( a )    KUT_P_TEST( (a), KUT_OP_TRUE, #a, ", expression: " #a " is TRUE", 0 )
+
+/// Private macro for 'false' test
+#define KUT_P_FALSE( a )   KUT_P_TEST( false == (a), KUT_OP_FALSE, #a, ", expression: " #a " is FALSE", 0 )
+
+//#define KUT_P_DOQUIT if(kut_data.DoQuit == true) exit(1)
+
+///@}
+
+//-------------------------------------------------------------------------------------------
+/// \name Set of macros to be used inside the test function
+//@{
+
+#ifdef KUT_FAST_MODE
+
+#define KUT_MSG( a ) \
+	{ \
+		kut_data.count_test1++; \
+		kut_data.count_test2 = 0; \
+	}
+#define KUT_EQ( a, b )       KUT_P_EQ( a, b )
+#define KUT_EQ_NS( a, b )    KUT_P_EQ( a, b )
+#define KUT_NEQ KUT_DIFF
+#define KUT_DIFF( a, b )     KUT_P_DIFF( a, b )
+#define KUT_DIFF_NS( a, b )  KUT_P_DIFF( a, b )
+#define KUT_LESS( a, b )     KUT_P_LESS( a, b )
+#define KUT_LESS_NS( a, b )  KUT_P_LESS( a, b )
+#define KUT_TRUE( a )        KUT_P_TRUE( a )
+#define KUT_TRUE_NS( a )     KUT_P_TRUE( a )
+#define KUT_TRUE_2( a, b )   KUT_P_TRUE( a )
+#define KUT_TRUE_2P( a, b )  KUT_P_TRUE( a )
+#define KUT_FALSE( a )       KUT_P_FALSE( a )
+#define KUT_FALSE_NS( a )    KUT_P_FALSE( a )
+
+#else
+
+/// A macro useful for documenting the test log file. Argument is a string. Increments counter 1
+#define KUT_MSG( a ) \
+	{ \
+		kut_data.count_test1++; \
+		if( kut_verbose ) \
+		{ \
+			KUT_LOG << ENDL; \
+			kut_ctx->line_counter++; \
+			KUT_LOG2 <<std::dec<< "* Test msg (" << kut_data.count_test1 << "): " << (a) << kut_ctx->LineRef() << ENDL; \
+			std::cerr <<std::dec<< "* Test msg (" << kut_data.count_test1 << "): " << (a) << ENDL; \
+		} \
+		kut_data.count_test2 = 0; \
+	}
+
+/// Testing equality of 2 objects, by using its '==' operator. Streams values in output file on fail.
 #define KUT_EQ( a, b ) \
 	{ \
-		KUT_P_EQ( a, b ); \
-		KUT_P_STREAM_VALUES( a, b ); \
-	}
+		KUT_P_EQ( a, b ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// testing equality of 2 objects, by using the '==' operator. Does NOT streams values in output file on fail.
+#define KUT_EQ_NS( a, b ) \
+	{ \
+		KUT_P_EQ( a, b ); \
+	}
+
+/// just an alias
+#define KUT_NEQ KUT_DIFF
+
+/// testing inequality of 2 objects, by using the '!=' operator. Streams values in output file on fail.
+#define KUT_DIFF( a, b ) \
+	{ \
+		KUT_P_DIFF( a, b ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// testing inequality of 2 objects, by using the '!=' operator. Does NOT stream values in output file on fail.
+#define KUT_DIFF_NS( a, b ) \
+	{ \
+		KUT_P_DIFF( a, b ); \
+	}
+
+/// testing ordering of 2 objects, by using the '<' operator. Streams values in output file on fail.
+#define KUT_LESS( a, b ) \
+	{ \
+		KUT_P_LESS( a, b ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// testing ordering of 2 objects, by using the '<' operator. Does NOT stream values in output file on fail.
+#define KUT_LESS_NS( a, b ) \
+	{ \
+		KUT_P_LESS( a, b ); \
+	}
+
+
+
+
+/// testing if expression \b a evaluates to true. Streams the object in output file on fail.
+/**
+*/
+#define KUT_TRUE( a ) \
+	{ \
+		KUT_P_TRUE( a ); \
+		if( kut_data.kut_failflag && kut_verbose ) \
+			kut_log_line( "   - " #a " : false" ); \
+	}
+
+/// testing if expression evaluates to true. Does NOT stream the object in output file on fail.
+#define KUT_TRUE_NS( a ) \
+	{ \
+		KUT_P_TRUE( a ); \
+	}
+
+
+/// testing if expression \b a evaluates to true. Prints the second argument \b b (object) in output file on fail.
+#define KUT_TRUE_2( a, b ) \
+	{ \
+		KUT_P_TEST( (a), KUT_OP_TRUE, #a, ", expr: " #a, 1 ); \
+		if( kut_data.kut_failflag && kut_verbose ) \
+			kut_log_value( "   - " #b " : ", (b) ); \
+	}
+
+/// testing if expression \b a evaluates to true. Same as KUT_TRUE_2, kept for compatibility: an object with a member function
+/// "Print( FILE* );" and no stream operator is printed in the log file with it (see \ref macros)
+#define KUT_TRUE_2P( a, b ) KUT_TRUE_2( a, b )
+
+/// Testing if expression \b a evaluates to false. Streams the object in output file on fail.
+#define KUT_FALSE( a ) \
+	{ \
+		KUT_P_FALSE( a ); \
+		if( kut_data.kut_failflag ) \
+			kut_log_line( "   - " #a " : 1" ); \
+	}
+
+/// Testing if expression evaluates to false. Does NOT stream the object in output file on fail.
+#define KUT_FALSE_NS( a ) \
+	{ \
+		KUT_P_FALSE( a ); \
+	}
+
+#endif // KUT_FAST_MODE
+
+/// Private macro for the floating-point comparisons: compares with the tolerance \c tol, and writes the errors on fail
+#define KUT_P_EQ_TOL( a, b, tol, text ) \
+	{ \
+		KUT_P_SITE( KUT_OP_EQ_F, #a " == " #b, text, 1 ); \
+		kut_begin( kut_data, __FILE__, __LINE__ ); \
+		kut_end( kut_data, &kut_site, kut_fp_eq( &kut_site, (a), (b), (tol) ) ); \
+		if( kut_data.kut_failflag && kut_verbose ) \
+			kut_fp_report( (a), (b) ); \
+	}
+
+/// Testing equality of floating point values, with the current tolerance: absolute KUT_EPSILON by default, see KUT_TOL_SCOPE.
+/// Streams values in output file on fail.
+/** Requirement: \c a and \c b need to be arithmetic values, or have the '-' operator defined, returning a floating-point value
+(only the absolute tolerance is then used).
+*/
+#define KUT_EQ_F( a, b ) \
+	{ \
+		KUT_P_EQ_TOL( a, b, kut_data.tol, ", expr: " #a " == " #b ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// testing equality of floating point values \b a and \b b, with the current tolerance. Does NOT stream values in output file on fail.
+#define KUT_EQF_NS( a, b ) \
+	KUT_P_EQ_TOL( a, b, kut_data.tol, ", expr: " #a " == " #b )
+
+/// Testing equality of floating point values, with the tolerance \b tol (see KUT_TOL). Streams values in output file on fail.
+#define KUT_EQ_TOL( a, b, tol ) \
+	{ \
+		KUT_P_EQ_TOL( a, b, tol, ", expr: " #a " == " #b ", tolerance: " #tol ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// Testing ordering of floating point values, using '<'. Streams values in output file on fail.
+#define KUT_LESS_F( a, b ) \
+	{ \
+		KUT_P_TEST( (a) < (b), KUT_OP_LESS, #a " < " #b, ", expr: " #a " < " #b, 1 ); \
+		KUT_P_STREAM_VALUES( a, b ); \
+	}
+
+/// Sets the tolerance of KUT_EQ_F and KUT_EQF_NS (see KUT_TOL) until the end of the current scope
+#define KUT_TOL_SCOPE( tol ) \
+	KUT_TOL_GUARD KUT_P_CONCAT( kut_tol_guard_, __LINE__ )( kut_data, tol )
+
+/// Testing equality of two contiguous ranges (containers with a \c data() member function, or arrays), element by element,
+/// with their '==' operator. Logs the sizes and the first mismatching elements on fail (see KUT_RANGE_MAX_REPORT and KUT_RANGE_COUNT_ALL).
+/**
+Integers, enumerations, pointers and floating-point values are compared with SIMD instructions, when available.
+*/
+#define KUT_EQ_RANGE( a, b ) \
+	{ \
+		KUT_P_SITE( KUT_OP_EQ_RANGE, #a " == " #b, ", expression: " #a " == " #b, 0 ); \
+		kut_begin( kut_data, __FILE__, __LINE__ ); \
+		kut_range_eq( kut_data, &kut_site, (a), (b) ); \
+	}
+
+/// Testing equality of two contiguous ranges of floating-point values, element by element, with the tolerance \b tol (see KUT_TOL).
+/// Logs the sizes and the first mismatching elements on fail.
+/**
+The absolute and relative tolerances are checked with SIMD instructions, when available.
+*/
+#define KUT_EQ_RANGE_TOL( a, b, tol ) \
+	{ \
+		KUT_P_SITE( KUT_OP_EQ_RANGE_F, #a " == " #b, ", expression: " #a " == " #b ", tolerance: " #tol, 0 ); \
+		kut_begin( kut_data, __FILE__, __LINE__ ); \
+		kut_range_near( kut_data, &kut_site, (a), (b), (tol) ); \
+	}
+
+/// Testing equality of two contiguous ranges of floating-point values, element by element, with the absolute tolerance \b eps.
+#define KUT_EQ_RANGE_F( a, b, eps ) \
+	{ \
+		KUT_P_SITE( KUT_OP_EQ_RANGE_F, #a " == " #b, ", expression: " #a " == " #b ", with tolerance " #eps, 0 ); \
+		kut_begin( kut_data, __FILE__, __LINE__ ); \
+		kut_range_near( kut_data, &kut_site, (a), (b), kut_abs( eps ) ); \
+	}
+
+/// Test succeeds if the block of code following the macro does at most \c n allocations (see \ref alloc)
+/**
+\verbatim
+KUT_ALLOC_SCOPE_MAX( 1 )
+{
+	std::vector<int> v( 100 );
+}
+\endverbatim
+Without allocation tracking (KUT_TRACK_ALLOC not defined), the block is run but no test is done.
+*/
+#define KUT_ALLOC_SCOPE_MAX( n ) \
+	for( KUT_ALLOC_SCOPE kut_alloc_scope( kut_data, __FILE__, __LINE__, "nb of allocations <= " #n, ", expression: nb of allocations <= " #n, __PRETTY_FUNCTION__, (n) ); kut_alloc_scope.Next(); )
+
+/// Test succeeds if all the memory allocated by the block of code following the macro is freed when it ends (see \ref alloc)
+#define KUT_NO_LEAK \
+	for( KUT_ALLOC_SCOPE kut_alloc_scope( kut_data, __FILE__, __LINE__, "no leak", ", expression: no leak", __PRETTY_FUNCTION__, -1 ); kut_alloc_scope.Next(); )
+
+///@}
+
+
+//----------------------------------------------------------------------------
+/// A macro to be included in each class to be tested
+/**
+Just add the following lines at the end of the class:
+\verbatim
+#ifdef TESTMODE
+	KUT_CLASS_DECLARE
+#endif
+\endverbatim
+\warning : no semi colon !
+
+For an example, see file demo/classA.hpp
+
+Inside: This macro adds a public method to the class named 'KUT_CUTM()
+(which stands for Class Unit Test Method )
+
+*/
+#define KUT_CLASS_DECLARE \
+	public: \
+		KUT_TYPE KUT_CUTM(); \
+	private:
+
+//----------------------------------------------------------------------------
+/// \name Set of macros for the testing class code
+//@{
+
+/// a macro that declares the test member function, and registers it so it is run by KUT_MAIN (see \ref autoreg). \warning No Semicolon !
+/// \c a is the name of the class without its namespace: for a class inside a namespace, use this macro inside the namespace
+#define KUT_DEF_TEST_METHOD( a ) \
+	static KUT_REGISTRAR KUT_P_CONCAT( kut_registrar_, a )( #a, 0, &kut_class_test<a>, __FILE__, __LINE__ ); \
+	KUT_TYPE a::KUT_CUTM()
+
+/// Class Test Method Start. Configures everything for unit test of class \b a (inside Test() function)
+#define KUT_CTM_START(a) \
+	std::string kut_class_name = #a; \
+	KUT_TYPE kut_data; \
+	kut_ctx->fail_file.clear(); \
+	kut_ctx->fail_line.clear(); \
+	kut_ctx->line_counter++; \
+	KUT_LOG2 << "- BEGIN unit test of class " << #a << ", file: " << __FILE__ << kut_ctx->LineRef() << ENDL; \
+	std::cerr << "- BEGIN unit test of class " << #a << ", file: " << __FILE__ << ENDL << ENDL; \
+
+
+
+/// Class Test Method end. Prints out results of test of class, and returns nb of failures (inside Test() function)
+#define KUT_CTM_END \
+	kut_ctx->MergeThreadResults( kut_data ); \
+	kut_ctx->PrintFpStats(); \
+	kut_ctx->PrintAllocStats(); \
+	kut_ctx->line_counter++; \
+	KUT_LOG2 << "- END Unit test of class " << kut_class_name << ", " << kut_data.count_test <<" tests done and " << kut_data.count_fail <<" failure(s)" << kut_ctx->LineRef() << ENDL; \
+	if( kut_data.count_fail > 0 ) \
+	{ \
+		for( size_t kut_i=0; kut_i<kut_ctx->fail_line.size(); kut_i++ ) \
+		{ \
+			KUT_LOG << " - failed at line " << kut_ctx->fail_line.at(kut_i) \
+				<< " of file " << kut_ctx->fail_file.at(kut_i) << ENDL; \
+		} \
+	} \
+	KUT_LOG << ENDL; \
+	return kut_data
+
+///@}
+
+//----------------------------------------------------------------------------
+/// \name Set of macros to be used inside the test app
+//@{
+
+/// Test initialisation.
+#define KUT_MAIN_START KUT_MAIN_START_ARGS( 0, 0 )
+
+/// Test initialisation, with the command line options (see \ref parallel). Use this in a <tt>main( int argc, char** argv )</tt>
+#define KUT_MAIN_START_ARGS( argc, argv ) \
+	KUT_MASTER kut_m; \
+	kut_m.ParseArgs( argc, argv ); \
+	std::cout << " Test : start\n"; \
+	if( !kut_logsink.Open( KUT_FILENAME ) ) \
+	{ \
+		std::cout << "KUT: Unable to open log file " << KUT_FILENAME <<", exiting..." << ENDL; \
+		std::cerr << "KUT: Unable to open log file " << KUT_FILENAME <<", exiting..." << ENDL; \
+		exit(1); \
+	} \
+	if( !freopen( "stderr.txt", "wt", stderr ) ) \
+	{ \
+		std::cout << "KUT: Unable to open stderr/cerr file, exiting..." << ENDL; \
+		std::cerr << "KUT: Unable to open stderr/cerr file, exiting..." << ENDL; \
+		exit(1); \
+	} \
+	kut_install_crash_handler(); \
+	time_t t = time(0); \
+	KUT_LOG << "KUT logfile, created at " << asctime( localtime( &t ) ); \
+	KUT_LOG << " - version of KUT is " << KUT_VERSION << ENDL; \
+	kut_m.Init()
+
+
+
+/// Test end. Returns the total nb of failures
+#define KUT_MAIN_END \
+	kut_m.RunQueue(); \
+	kut_m.StopWatchdog(); \
+	kut_m.PrintSummary(); \
+	return kut_m.NbFailureTot
+
+
+/// Unit test of a class. This macro is to be used in the main test program.
+/**
+This macro tests the class 'A', i.e. :
+ - creates an object of that type (or takes it from its pool, see \ref fixtures)
+ - calls the test member function on it (whose name is KUT_CUTM, but you don't really need to know this...)
+
+If several worker threads are used, the test is only queued, and will be run by KUT_MAIN_END (see \ref parallel).
+*/
+#define KUT_TEST_CLASS( A ) \
+	kut_m.AddUnitTest( KUT_UNIT_TEST( #A, 0, &kut_class_test<A> ) )
+
+/// Call of a function dedicated to the test of a global function.
+/// This macro is to be used in the main test program.
+/**
+Please note that the function \c a DOES NOT need to be declared, the macro takes care of this.
+*/
+#define KUT_TEST_FUNC( a ) \
+	{ \
+		extern KUT_TYPE a(); \
+		kut_m.AddUnitTest( KUT_UNIT_TEST( #a, 1, &a ) ); \
+	}
+
+/// Returns a reference to the fixture of type \c F of the current unit test, built, pooled and reset as given by KUT_FIXTURE_TRAITS (see \ref fixtures)
+#define KUT_FIXTURE( F ) kut_fixture<F>()
+
+/// Defines a test function, and registers it so it is run by KUT_MAIN (see \ref autoreg). \warning No Semicolon !
+/**
+\code
+KUT_TEST_FUNCTION( TestFoo )
+{
+	KUT_FT_START( foo );
+	KUT_EQ( foo(1), 2 );
+	KUT_FT_END;
+}
+\endcode
+*/
+#define KUT_TEST_FUNCTION( a ) \
+	KUT_TYPE a(); \
+	static KUT_REGISTRAR KUT_P_CONCAT( kut_registrar_, a )( #a, 1, &a, __FILE__, __LINE__ ); \
+	KUT_TYPE a()
+
+/// Defines a test function template, instantiated and registered for each of the types given after its name (see \ref typed). \warning No Semicolon !
+/**
+In the body, the type is \c T:
+\code
+KUT_TYPED_TEST( TestSum, float, double, int8_t )
+{
+	KUT_FT_START( sum );
+	std::vector<T> v( 10, T(1) );
+	KUT_EQ( sum( v ), T(10) );
+	KUT_FT_END;
+}
+\endcode
+*/
+#define KUT_TYPED_TEST( a, ... ) \
+	template<typename T> KUT_TYPE a(); \
+	struct KUT_P_CONCAT( kut_typed_, a ) \
+	{ \
+		template<typename T> static KUT_UT_FUNC Func() { return &a<T>; } \
+	}; \
+	static KUT_TYPED_REGISTRAR<KUT_P_CONCAT( kut_typed_, a ), __VA_ARGS__> KUT_P_CONCAT( kut_registrar_, a )( #a, 1, #__VA_ARGS__, __FILE__, __LINE__ ); \
+	template<typename T> KUT_TYPE a()
+
+/// Defines the test method of the class template \c a, and registers it for each of the types given after its name (see \ref typed). \warning No Semicolon !
+/**
+The class template has one type parameter, and holds KUT_CLASS_DECLARE. In the body, the type is \c T.
+*/
+#define KUT_DEF_TYPED_TEST_METHOD( a, ... ) \
+	struct KUT_P_CONCAT( kut_typed_, a ) \
+	{ \
+		template<typename T> static KUT_UT_FUNC Func() { return &kut_class_test< a<T> >; } \
+	}; \
+	static KUT_TYPED_REGISTRAR<KUT_P_CONCAT( kut_typed_, a ), __VA_ARGS__> KUT_P_CONCAT( kut_registrar_, a )( #a, 0, #__VA_ARGS__, __FILE__, __LINE__ ); \
+	template<typename T> KUT_TYPE a<T>::KUT_CUTM()
 
-/// testing equality of 2 objects, by using the '==' operator. Does NOT streams values in output file on fail.
-#define KUT_EQ_NS( a, b ) \
+/// Defines the main() function of the test program, running all the registered unit tests (see \ref autoreg)
+/**
+Also does the global allocation (KUT_ALLOC), so this is all that is needed in the main test file.
+*/
+#define KUT_MAIN \
+	KUT_ALLOC; \
+	int main( int argc, char** argv ) \
 	{ \
-		KUT_P_EQ( a, b ); \
+		KUT_MAIN_START_ARGS( argc, argv ); \
+		kut_m.AddRegisteredTests(); \
+		KUT_MAIN_END; \
 	}
 
-/// just an alias
-#define KUT_NEQ KUT_DIFF
+///@}
 
-/// testing inequality of 2 objects, by using the '!=' operator. Streams values in output file on fail.
-#define KUT_DIFF( a, b ) \
-	{ \
-		KUT_P_DIFF( a, b ); \
-		KUT_P_STREAM_VALUES( a, b ); \
-	}
+//----------------------------------------------------------------------------
+/// \name two macros for testing of a function
+//@{
 
-/// testing inequality of 2 objects, by using the '!=' operator. Does NOT stream values in output file on fail.
-#define KUT_DIFF_NS( a, b ) \
-	{ \
-		KUT_P_DIFF( a, b ); \
-	}
+/// Configures everything for test of function \c a
+/** Actually, the argument is only for documentation purposes, not used at present
+*/
+#define KUT_FT_START(a) \
+	KUT_TYPE kut_data; \
+	kut_ctx->fail_file.clear(); \
+	kut_ctx->fail_line.clear(); \
+	kut_ctx->line_counter++; \
+	KUT_LOG2 << "- BEGIN unit test of function '" << #a << "()' through test function "<< __FUNCTION__ << kut_ctx->LineRef() << ENDL; \
+	std::cerr << "- BEGIN unit test of function '" << #a << "()' through test function "<< __FUNCTION__ << ENDL;
 
-/// testing ordering of 2 objects, by using the '<' operator. Streams values in output file on fail.
-#define KUT_LESS( a, b ) \
-	{ \
-		KUT_P_LESS( a, b ); \
-		KUT_P_STREAM_VALUES( a, b ); \
-	}
 
-/// testing ordering of 2 objects, by using the '<' operator. Does NOT stream values in output file on fail.
-#define KUT_LESS_NS( a, b ) \
+/// End of test function
+#define KUT_FT_END \
+	kut_ctx->MergeThreadResults( kut_data ); \
+	kut_ctx->PrintFpStats(); \
+	kut_ctx->PrintAllocStats(); \
+	KUT_LOG << "\n- END of test function, "<< kut_data.count_test <<" tests and " << kut_data.count_fail<<" failure(s)\n\n"; \
+	return kut_data
+
+/// Useful for using test functions inside a class test, see class1.cpp for an example
+#define KUT_EXECFUNC( a ) \
+	if( kut_verbose ) \
+		KUT_LOG << "\n - Starting function : " << #a << ENDL; \
+	kut_data.count_test1++; \
+	kut_data.count_test2 = 0; \
 	{ \
-		KUT_P_LESS( a, b ); \
+		KUT_TIMER kut_timer; \
+		kut_data = a; \
+		kut_ctx->v_timing.push_back( kut_timer.Stop( #a, 2 ) ); \
+	} \
+	if( kut_data.DoQuit == true ) \
+		return kut_data;
+///@}
+
+//----------------------------------------------------------------------------
+/// \name Macros for using the test macros in a thread started inside a unit test
+//@{
+
+/// To be put at the beginning of a thread started inside a unit test, before using any test macro
+/**
+The thread gets its own context and counters, so the test macros can be used without any lock. For example:
+\code
+	std::thread t( [&]()
+	{
+		KUT_THREAD_START;
+		KUT_EQ( foo(), 42 );
+		KUT_THREAD_END;
+	} );
+	...
+	t.join();
+\endcode
+The thread needs to capture \c kut_data by reference, and must be joined before the end of the unit test.
+*/
+#define KUT_THREAD_START \
+	KUT_CONTEXT* kut_parent_ctx = kut_data.ctx; \
+	KUT_CONTEXT  kut_thread_ctx; \
+	kut_thread_ctx.owner = kut_parent_ctx->owner; \
+	KUT_CONTEXT* kut_previous_ctx = kut_ctx; \
+	kut_ctx = &kut_thread_ctx; \
+	KUT_TYPE kut_thread_data; \
+	kut_thread_data.StopTestOnFail = kut_data.StopTestOnFail; \
+	KUT_TYPE& kut_data = kut_thread_data
+
+/// To be put at the end of the thread. Its results are added to the ones of the unit test by KUT_CTM_END / KUT_FT_END
+/// The context the thread had before KUT_THREAD_START is restored (a worker thread may run other unit tests after)
+#define KUT_THREAD_END \
+	kut_parent_ctx->AddThreadResults( kut_thread_ctx, kut_data ); \
+	kut_ctx = kut_previous_ctx
+///@}
+
+//----------------------------------------------------------------------------
+/// Nb of worker threads used by KUT_LOOP_PAR_START, 0 means "one per core"
+#ifndef KUT_LOOP_PAR_JOBS
+	#define KUT_LOOP_PAR_JOBS 0
+#endif
+
+/// Max nb of loop macros (KUT_LOOP_TRUE, KUT_LOOP_EQU, ...) in a test loop
+#ifndef KUT_LOOP_MAX_SITES
+	#define KUT_LOOP_MAX_SITES 32
+#endif
+
+/// Internal data structure used, static description of a loop macro (see \ref iterative)
+struct KUT_LOOP_SITE
+{
+	const char* expr_a;
+	const char* op;
+	const char* expr_b;
+};
+
+/// Internal data structure used, failure counters of a test loop, one slot per loop macro (see \ref iterative)
+/**
+The slot of each loop macro is held by a function-local static, so the loop does not allocate anything.
+*/
+struct KUT_LOOP_STATE
+{
+	unsigned int         fails[KUT_LOOP_MAX_SITES];      ///< nb of failures of each loop macro
+	unsigned int         first_fail[KUT_LOOP_MAX_SITES]; ///< first iteration where each loop macro failed
+	const KUT_LOOP_SITE* site[KUT_LOOP_MAX_SITES];       ///< 0 if the loop macro has never been reached
+	bool                 fail_flag;
+
+	KUT_LOOP_STATE() : fail_flag(false)
+	{
+		for( int i=0; i<KUT_LOOP_MAX_SITES; i++ )
+		{
+			fails[i]      = 0;
+			first_fail[i] = ~0u;
+			site[i]       = 0;
+		}
 	}
 
+/// Adds the counters of \c s
+	void Add( const KUT_LOOP_STATE& s )
+	{
+		for( int i=0; i<KUT_LOOP_MAX_SITES; i++ )
+		{
+			fails[i]     += s.fails[i];
+			first_fail[i] = std::min( first_fail[i], s.first_fail[i] );
+			if( !site[i] )
+				site[i] = s.site[i];
+		}
+		fail_flag = fail_flag || s.fail_flag;
+	}
+};
 
+/// Internal data structure used, a test loop. With KUT_LOOP_PAR_START, the iterations are run by worker threads,
+/// each one with its own counters, added at the end
+struct KUT_LOOP
+{
+	KUT_LOOP_STATE state;   ///< counters of a serial loop, and total of the workers
+	unsigned int   nb_iter;
+	std::function<void(unsigned int,KUT_LOOP_STATE&,bool)> body; ///< body of a parallel loop, called with the iteration index, the counters of the worker, and true on its first iteration
 
+	KUT_LOOP( unsigned int n ) : nb_iter(n)
+	{}
 
-// testing equality of floating point values \b a and \b b. You need to include math.h in your code if you want to use this macro.
-// Does NOT stream values in output file on fail.
-/*#define KUT_EQF_NS( a, b ) \
-	{ \
-		KUT_P2; \
-		if( fabs( (a) - (b) ) < KUT_EPSILON ) \
-			KUT_P11 \
-		KUT_LOG << ", expr: " << #a << " == " << #b << ENDL; \
+/// Runs the body of a parallel loop (does nothing for a serial one), by chunks of consecutive iterations
+	void Run()
+	{
+		if( !body )
+			return;
+		unsigned int nb_workers = KUT_LOOP_PAR_JOBS > 0 ? KUT_LOOP_PAR_JOBS : std::thread::hardware_concurrency();
+		if( nb_workers == 0 )
+			nb_workers = 1;
+		size_t nb_chunks = std::min( (size_t)nb_iter, (size_t)nb_workers * 16 );
+		std::vector<KUT_LOOP_STATE> v_worker( nb_workers );
+		std::vector<char>           v_started( nb_workers, 0 );
+		kut_parallel_for( nb_chunks, nb_workers, [&]( size_t chunk, unsigned int w )
+		{
+			unsigned int begin = (unsigned int)( (uint64_t)nb_iter * chunk / nb_chunks );
+			unsigned int end   = (unsigned int)( (uint64_t)nb_iter * (chunk+1) / nb_chunks );
+			for( unsigned int i=begin; i<end; i++ )
+			{
+				body( i, v_worker[w], !v_started[w] );
+				v_started[w] = 1;
+			}
+		} );
+		for( size_t w=0; w<v_worker.size(); w++ )
+			state.Add( v_worker[w] );
 	}
-*/
+};
 
-/// testing if expression \b a evaluates to true. Streams the object in output file on fail.
+//----------------------------------------------------------------------------
+/// \name Macros allowing iterating several tests (see page \ref iterative)
+//@{
+
+/// Private macro, common beginning of KUT_LOOP_START and KUT_LOOP_PAR_START
 /**
+The loop macros get their slot from \c kut_loop_nb_sites, the first time each of them is reached.
 */
-#define KUT_TRUE( a ) \
+#define KUT_LOOP_P_START( nb_iter ) \
+		int kut_loop_line = __LINE__; \
+		static std::atomic<int> kut_loop_nb_sites( 0 ); \
+		if( kut_verbose ) \
+			KUT_LOG << std::dec<< " * Test " << ++kut_data.count_test << " (loop type) (" << kut_data.count_test1 << "." << kut_data.count_test2 <<")\n"; \
+		unsigned int kut_loop_nb_iter = nb_iter; \
+		KUT_LOOP kut_loop( kut_loop_nb_iter );
+
+/// Start a loop
+#define KUT_LOOP_START( nb_iter ) \
 	{ \
-		KUT_P_TRUE( a ); \
-		if( kut_data.kut_failflag && kut_verbose ) \
+		KUT_LOOP_P_START( nb_iter ) \
+		KUT_LOOP_STATE& kut_loop_state = kut_loop.state; \
+		for( unsigned int kut_i=0; kut_i<kut_loop_nb_iter; kut_i++ ) \
 		{ \
-			KUT_LOG << "   - " << #a << " : " << "false" << ENDL; \
-		} \
-	}
+			const bool kut_loop_first = ( kut_i == 0 );
 
-/// testing if expression evaluates to true. Does NOT stream the object in output file on fail.
-#define KUT_TRUE_NS( a ) \
+/// Start a loop whose iterations are run by several threads (see \ref iterative)
+/**
+Ends with KUT_LOOP_END, as a regular loop. Each thread has its own counters, added at the end,
+so the report is the same as with KUT_LOOP_START.
+*/
+#define KUT_LOOP_PAR_START( nb_iter ) \
 	{ \
-		KUT_P_TRUE( a ); \
-	}
+		KUT_LOOP_P_START( nb_iter ) \
+		kut_loop.body = [&]( unsigned int kut_i, KUT_LOOP_STATE& kut_loop_state, bool kut_loop_first ) \
+		{
 
-
-/// testing if expression \b a evaluates to true. Streams the second argument \b b (object) in output file on fail.
-/// \todo To be edited...
-#define KUT_TRUE_2( a, b ) \
-	{ \
-		KUT_P2; \
-		if( a ) \
-			KUT_P11; \
+/// End a loop (started with KUT_LOOP_START or KUT_LOOP_PAR_START)
+#define KUT_LOOP_END \
+		}; \
+		kut_loop.Run(); \
+		bool kut_fail_flag = kut_loop.state.fail_flag; \
 		if( kut_verbose ) \
 		{ \
-			KUT_LOG << ", expr: " << #a << ENDL; \
-			if( kut_data.kut_failflag && kut_verbose ) \
+			KUT_LOG << (kut_fail_flag ? "FAIL" : "PASS") << ", " << kut_loop_nb_iter << " iterations, at line "<< kut_loop_line << ENDL; \
+			for( int kut_i=0, kut_n=0; kut_i<KUT_LOOP_MAX_SITES; kut_i++ ) \
 			{ \
-				KUT_LOG << "   - " << #b << " : " << (b) << ENDL; \
+				const KUT_LOOP_SITE* kut_site = kut_loop.state.site[kut_i]; \
+				if( !kut_site ) \
+					continue; \
+				unsigned int kut_fails = kut_loop.state.fails[kut_i]; \
+				KUT_LOG << "   - subtest " << kut_data.count_test << "." << ++kut_n << ", expr: " << kut_site->expr_a; \
+				KUT_LOG2 << "  " << kut_site->op << " " << kut_site->expr_b; \
+				KUT_LOG2 << ", failed: "<< kut_fails; \
+				KUT_LOG2 << " over " << kut_loop_nb_iter << " (" << 100.0*kut_fails/kut_loop_nb_iter<<" %)"; \
+				if( kut_fails ) \
+					KUT_LOG2 << ", first at kut_i=" << kut_loop.state.first_fail[kut_i]; \
+				KUT_LOG2 << ENDL; \
 			} \
+			if( kut_loop_nb_sites > KUT_LOOP_MAX_SITES ) \
+				KUT_LOG << "   - " << kut_loop_nb_sites - KUT_LOOP_MAX_SITES << " loop macros not reported, increase KUT_LOOP_MAX_SITES" << ENDL; \
 		} \
+		if( kut_binlog ) \
+			kut_ctx->AddRecord( __FILE__, kut_loop_line, "loop", KUT_OP_LOOP, !kut_fail_flag, kut_data.count_test ); \
+		if( kut_fail_flag == true ) \
+		{ \
+			kut_data.count_fail++; \
+			kut_ctx->fail_file.push_back( __FILE__ ); \
+			kut_ctx->fail_line.push_back( kut_loop_line ); \
+			if( kut_data.StopTestOnFail ) \
+			{ \
+				std::cout << " -premature ending of test !\n"; \
+				kut_data.DoQuit = true; \
+				KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n"; \
+				KUT_LOG << " - in function : " << __PRETTY_FUNCTION__ << ENDL; \
+				KUT_LOG << " - Actual status : " << kut_data.count_test<<" tests done and " << kut_data.count_fail<<" failure(s)\n\n"; \
+				kut_premature_end( kut_data ); \
+				return kut_data; \
+			} \
+		}\
 	}
 
-/// testing if expression \b a evaluates to true. Prints the second argument \b b (object) in output, using its memberfunction  "Print( FILE* );"
-/// \todo To be edited...
-#define KUT_TRUE_2P( a, b ) \
+/// private macro: a loop macro, with its static description and its slot in the counters
+/**
+\param fail condition of failure
+*/
+#define KUT_LOOP_P_SITE( fail, a, op, b ) \
 	{ \
-		KUT_P2; \
-		if( a ) \
-			KUT_P11; \
-		if( kut_verbose ) \
+		static const int kut_loop_slot = kut_loop_nb_sites++; \
+		static const KUT_LOOP_SITE kut_loop_site = { a, op, b }; \
+		const bool kut_loop_slotted = ( kut_loop_slot < KUT_LOOP_MAX_SITES ); \
+		if( kut_loop_first && kut_loop_slotted ) \
+			kut_loop_state.site[kut_loop_slot] = &kut_loop_site; \
+		if( fail ) \
 		{ \
-			KUT_LOG << ", expr: " << #a << ENDL; \
-			if( kut_data.kut_failflag ) \
+			if( kut_loop_slotted ) \
 			{ \
-				KUT_LOG << "   - " << #b << " : "; \
-				b.Print( stderr ); \
+				kut_loop_state.site[kut_loop_slot] = &kut_loop_site; \
+				kut_loop_state.fails[kut_loop_slot]++; \
+				if( kut_i < kut_loop_state.first_fail[kut_loop_slot] ) \
+					kut_loop_state.first_fail[kut_loop_slot] = kut_i; \
 			} \
+			kut_loop_state.fail_flag = true; \
 		} \
 	}
 
-/// Testing if expression \b a evaluates to false. Streams the object in output file on fail.
-#define KUT_FALSE( a ) \
-	{ \
-		KUT_P_FALSE( a ); \
-		if( kut_data.kut_failflag ) \
-		{ \
-			KUT_LOG << "   - " << #a << " : " << true << ENDL; \
-		} \
+/// Testing if expression evaluates to true, inside a test loop
+#define KUT_LOOP_TRUE( a ) \
+	KUT_LOOP_P_SITE( (a)==false, #a, "TRUE", "" )
+
+/// Testing if expression evaluates to false, inside a test loop
+#define KUT_LOOP_FALSE( a ) \
+	KUT_LOOP_P_SITE( (a)==true, #a, "FALSE", "" )
+
+/// Testing is the two arguments are equal, using their '==' operator (needs to be defined)
+#define KUT_LOOP_EQU( a, b ) \
+	KUT_LOOP_P_SITE( false == ((a) == (b)), #a, "EQUAL", #b )
+
+/// Testing is the two arguments are different, using their '!=' operator (needs to be defined)
+#define KUT_LOOP_DIFF( a, b ) \
+	KUT_LOOP_P_SITE( false == ((a) != (b)), #a, "DIFF", #b )
+
+/// Testing ordering of 2 objects, by using the '<' operator (needs to be defined)
+#define KUT_LOOP_LESS( a, b ) \
+	KUT_LOOP_P_SITE( false == ((a) < (b)), #a, "LESS", #b )
+
+///@}
+
+//----------------------------------------------------------------------------
+/// \name Property tests (see page \ref property)
+//@{
+
+/// Seed of the property tests, can be changed at run time with the environment variable \c KUT_SEED
+#ifndef KUT_SEED
+	#define KUT_SEED 0
+#endif
+
+/// Nb of cases generated at once by a property test
+#ifndef KUT_PROPERTY_BATCH
+	#define KUT_PROPERTY_BATCH 256
+#endif
+
+/// Max nb of candidates tried when shrinking a counterexample
+#ifndef KUT_PROPERTY_MAX_SHRINK
+	#define KUT_PROPERTY_MAX_SHRINK 10000
+#endif
+
+/// Mixes the bits of \c x (splitmix64)
+inline uint64_t kut_splitmix64( uint64_t x )
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = ( x ^ (x >> 30) ) * 0xBF58476D1CE4E5B9ULL;
+	x = ( x ^ (x >> 27) ) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+/// Seed of all the property tests: \c KUT_SEED environment variable, or KUT_SEED macro
+inline uint64_t kut_base_seed()
+{
+	static uint64_t seed = []() -> uint64_t
+	{
+		const char* env = getenv( "KUT_SEED" );
+		return env ? strtoull( env, 0, 10 ) : (uint64_t)KUT_SEED;
+	}();
+	return seed;
+}
+
+/// Random generator of the property tests (xorshift64*), small and fast, as one is seeded for each case
+struct KUT_RNG
+{
+	uint64_t s;
+
+	explicit KUT_RNG( uint64_t seed ) : s( kut_splitmix64( seed ) | 1 )
+	{}
+	uint64_t Next()
+	{
+		s ^= s >> 12;
+		s ^= s << 25;
+		s ^= s >> 27;
+		return s * 2685821657736338717ULL;
+	}
+/// Returns a value in [0,n[ (any value if \c n is 0)
+	uint64_t Below( uint64_t n )
+	{
+		if( n == 0 )
+			return Next();
+		if( n <= 0xFFFFFFFFULL )
+			return ( (Next() >> 32) * n ) >> 32;
+		return Next() % n;
+	}
+/// Returns a value in [0,1[
+	double Uniform()
+	{
+		return (Next() >> 11) * ( 1. / 9007199254740992. );
 	}
+};
 
-/// Testing if expression evaluates to false. Does NOT stream the object in output file on fail.
-#define KUT_FALSE_NS( a ) \
-	{ \
-		KUT_P_FALSE( a ); \
+/// Generator of integers in [lo,hi], shrinking towards 0 (or the bound closest to 0)
+/**
+A generator fills a value in place (so the memory of strings and containers is reused from one batch to the next),
+and gives the candidates to try for shrinking a failing value, simplest first.
+*/
+template<typename T>
+struct KUT_GEN_INT
+{
+	typedef T value_type;
+	T lo, hi;
+
+	KUT_GEN_INT( T l, T h ) : lo(l), hi(h)
+	{}
+	void operator()( KUT_RNG& rng, T& v ) const
+	{
+		v = (T)( (uint64_t)lo + rng.Below( (uint64_t)hi - (uint64_t)lo + 1 ) );
+	}
+	void Shrink( const T& v, std::vector<T>& out ) const
+	{
+		T target = lo > 0 ? lo : ( hi < 0 ? hi : 0 );
+		if( v == target )
+			return;
+		out.push_back( target );
+		T half = (T)( target + ( v/2 - target/2 ) );
+		if( half != target && half != v )
+			out.push_back( half );
+		T step = v > target ? (T)(v-1) : (T)(v+1);
+		if( step != target && step != half )
+			out.push_back( step );
 	}
+};
 
-///@}
+/// Generator of floating point values in [lo,hi[, shrinking towards 0 (or the bound closest to 0), and towards integer values
+template<typename T>
+struct KUT_GEN_FLOAT
+{
+	typedef T value_type;
+	T lo, hi;
 
+	KUT_GEN_FLOAT( T l, T h ) : lo(l), hi(h)
+	{}
+	void operator()( KUT_RNG& rng, T& v ) const
+	{
+		v = lo + (T)( (hi-lo) * rng.Uniform() );
+	}
+	void Shrink( const T& v, std::vector<T>& out ) const
+	{
+		T target = lo > 0 ? lo : ( hi < 0 ? hi : 0 );
+		if( v == target )
+			return;
+		out.push_back( target );
+		T t = std::trunc( v );
+		if( t != v && t >= lo && t < hi )
+			out.push_back( t );
+		T half = target + ( v - target ) / 2;
+		if( half != v && std::fabs( v - target ) > 1e-6 * ( std::fabs( v ) + 1 ) )
+			out.push_back( half );
+	}
+};
 
-//----------------------------------------------------------------------------
-/// A macro to be included in each class to be tested
+/// Shrinking candidates of a sequence (std::string, std::vector): removes half of it, then each element
+template<typename S>
+void kut_shrink_length( const S& v, size_t min_len, std::vector<S>& out )
+{
+	size_t n = v.size();
+	if( n <= min_len )
+		return;
+	if( min_len == 0 )
+		out.push_back( S() );
+	size_t half = n / 2;
+	if( half >= min_len && half > 0 )
+	{
+		out.push_back( S( v.begin(), v.begin()+half ) );
+		out.push_back( S( v.begin()+(n-half), v.end() ) );
+	}
+	for( size_t i=0; i<n && i<64; i++ )
+	{
+		S s( v );
+		s.erase( s.begin()+i );
+		out.push_back( s );
+	}
+}
+
+/// Generator of strings of length in [min_len,max_len], with characters taken from \c charset
+struct KUT_GEN_STRING
+{
+	typedef std::string value_type;
+	size_t      min_len, max_len;
+	std::string charset;
+
+	KUT_GEN_STRING( size_t mi, size_t ma, const std::string& cs ) : min_len(mi), max_len(ma), charset(cs)
+	{}
+	void operator()( KUT_RNG& rng, std::string& v ) const
+	{
+		v.resize( min_len + rng.Below( max_len - min_len + 1 ) );
+		for( size_t i=0; i<v.size(); i++ )
+			v[i] = charset[ rng.Below( charset.size() ) ];
+	}
+	void Shrink( const std::string& v, std::vector<std::string>& out ) const
+	{
+		kut_shrink_length( v, min_len, out );
+		for( size_t i=0; i<v.size(); i++ )
+			if( v[i] != charset[0] )
+			{
+				std::string s( v );
+				s[i] = charset[0];
+				out.push_back( s );
+				break;
+			}
+	}
+};
+
+/// Generator of vectors of length in [min_len,max_len], whose elements are given by the generator \c elem
+template<typename G>
+struct KUT_GEN_VECTOR
+{
+	typedef typename G::value_type      elem_type;
+	typedef std::vector<elem_type>      value_type;
+	G      elem;
+	size_t min_len, max_len;
+
+	KUT_GEN_VECTOR( const G& g, size_t mi, size_t ma ) : elem(g), min_len(mi), max_len(ma)
+	{}
+	void operator()( KUT_RNG& rng, value_type& v ) const
+	{
+		v.resize( min_len + rng.Below( max_len - min_len + 1 ) );
+		for( size_t i=0; i<v.size(); i++ )
+			elem( rng, v[i] );
+	}
+	void Shrink( const value_type& v, std::vector<value_type>& out ) const
+	{
+		kut_shrink_length( v, min_len, out );
+		std::vector<elem_type> v_elem;
+		for( size_t i=0; i<v.size(); i++ )
+		{
+			v_elem.clear();
+			elem.Shrink( v[i], v_elem );
+			for( size_t j=0; j<v_elem.size(); j++ )
+			{
+				value_type s( v );
+				s[i] = v_elem[j];
+				out.push_back( s );
+			}
+		}
+	}
+};
+
+/// Integers in [lo,hi]
+template<typename T>
+KUT_GEN_INT<T> kut_gen_int( T lo, T hi )
+{
+	return KUT_GEN_INT<T>( lo, hi );
+}
+
+/// Floating point values in [lo,hi[
+template<typename T>
+KUT_GEN_FLOAT<T> kut_gen_float( T lo, T hi )
+{
+	return KUT_GEN_FLOAT<T>( lo, hi );
+}
+
+/// Strings, by default of printable ASCII characters
+inline KUT_GEN_STRING kut_gen_string( size_t min_len, size_t max_len,
+	const std::string& charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~" )
+{
+	return KUT_GEN_STRING( min_len, max_len, charset );
+}
+
+/// Vectors of values given by the generator \c g
+template<typename G>
+KUT_GEN_VECTOR<G> kut_gen_vector( const G& g, size_t min_len, size_t max_len )
+{
+	return KUT_GEN_VECTOR<G>( g, min_len, max_len );
+}
+
+/// Internal data structure used, runs a property test (see KUT_PROPERTY)
 /**
-Just add the following lines at the end of the class:
-\verbatim
-#ifdef TESTMODE
-	KUT_CLASS_DECLARE
-#endif
-\endverbatim
-\warning : no semi colon !
+The cases are generated by batches of KUT_PROPERTY_BATCH, each one with a random generator seeded from the seed of the property
+and the index of the case, so a case does not depend on the previous ones.
+*/
+template<typename... G>
+struct KUT_PROPERTY_RUN
+{
+	typedef std::tuple<typename G::value_type...>        case_type;
+	typedef typename KUT_MAKE_INDEX_SEQ<sizeof...(G)>::type index_type;
 
-For an example, see file demo/classA.hpp
+	KUT_TYPE&          data;
+	const char*        name;
+	const char*        file;
+	int                line;
+	unsigned int       nb_iter;
+	std::tuple<G...>   gens;
+
+	KUT_PROPERTY_RUN( KUT_TYPE& d, const char* n, const char* f, int l, unsigned int nb, const G&... g )
+		: data(d), name(n), file(f), line(l), nb_iter(nb), gens( g... )
+	{}
+
+	uint64_t Seed() const
+	{
+		uint64_t h = 14695981039346656037ULL;         // FNV-1a of the name
+		for( const char* p=name; *p; p++ )
+			h = ( h ^ (unsigned char)*p ) * 1099511628211ULL;
+		return kut_splitmix64( kut_base_seed() ^ h );
+	}
+
+	template<size_t... I>
+	void Generate( KUT_RNG& rng, case_type& c, KUT_INDEX_SEQ<I...> ) const
+	{
+		int dummy[] = { 0, ( std::get<I>( gens )( rng, std::get<I>( c ) ), 0 )... };
+		(void)dummy;
+	}
 
-Inside: This macro adds a public method to the class named 'KUT_CUTM()
-(which stands for Class Unit Test Method )
+	template<typename F, size_t... I>
+	static bool Call( F& prop, const case_type& c, KUT_INDEX_SEQ<I...> )
+	{
+		return prop( std::get<I>( c )... );
+	}
 
-*/
-#define KUT_CLASS_DECLARE \
-	public: \
-		KUT_TYPE KUT_CUTM(); \
-	private:
+/// Returns true if the property holds for \c c, an exception being a failure
+	template<typename F>
+	static bool Check( F& prop, const case_type& c, std::string& msg )
+	{
+		try
+		{
+			return Call( prop, c, index_type() );
+		}
+		catch( const KUT_STOP_TEST& )
+		{
+			throw;
+		}
+		catch( const std::exception& e )
+		{
+			msg = e.what();
+		}
+		catch( ... )
+		{
+			msg = "unknown exception";
+		}
+		return false;
+	}
 
-//----------------------------------------------------------------------------
-/// \name Set of macros for the testing class code
-//@{
+/// Tries the shrinking candidates of argument \c I, keeps the first one that still fails
+	template<typename F, size_t I>
+	bool ShrinkArg( F&, case_type&, size_t&, std::string&, std::integral_constant<size_t,I>, std::true_type )
+	{
+		return false;
+	}
+	template<typename F, size_t I>
+	bool ShrinkArg( F& prop, case_type& c, size_t& nb_tries, std::string& msg, std::integral_constant<size_t,I>, std::false_type )
+	{
+		typedef typename std::tuple_element<I,case_type>::type arg_type;
+		std::vector<arg_type> v_cand;
+		std::get<I>( gens ).Shrink( std::get<I>( c ), v_cand );
+		for( size_t i=0; i<v_cand.size() && nb_tries < KUT_PROPERTY_MAX_SHRINK; i++ )
+		{
+			case_type c2( c );
+			std::get<I>( c2 ) = v_cand[i];
+			nb_tries++;
+			std::string msg2;
+			if( !Check( prop, c2, msg2 ) )
+			{
+				c   = c2;
+				msg = msg2;
+				return true;
+			}
+		}
+		return ShrinkArg( prop, c, nb_tries, msg, std::integral_constant<size_t,I+1>(), std::integral_constant<bool,I+1==sizeof...(G)>() );
+	}
 
-/// a macro that declares the test member function. \warning No Semicolon !
-#define KUT_DEF_TEST_METHOD( a ) KUT_TYPE a::KUT_CUTM()
+	template<size_t... I>
+	std::string Print( const case_type& c, KUT_INDEX_SEQ<I...> ) const
+	{
+		std::ostringstream oss;
+		oss << '(';
+		int dummy[] = { 0, ( oss << (I ? ", " : ""), kut_print_elem( oss, std::get<I>( c ) ), 0 )... };
+		(void)dummy;
+		oss << ')';
+		return oss.str();
+	}
 
-/// Class Test Method Start. Configures everything for unit test of class \b a (inside Test() function)
-#define KUT_CTM_START(a) \
-	std::string kut_class_name = #a; \
-	KUT_TYPE kut_data; \
-	kut_fail_file.clear(); \
-	kut_fail_line.clear(); \
-	KUT_LOG << "- BEGIN unit test of class " << #a << ", file: " << __FILE__ << " TEMP "<< kut_line_counter << ENDL; \
-	std::cerr << "- BEGIN unit test of class " << #a << ", file: " << __FILE__ << ENDL << ENDL; \
+/// Runs the property \c prop, called with one value of each generator, and returning true if the property holds
+	template<typename F>
+	void operator ->* ( F prop )
+	{
+		uint64_t seed = Seed();
+		std::vector<case_type> batch( KUT_PROPERTY_BATCH );
+		std::string msg;
+		for( unsigned int first=0; first<nb_iter; first+=KUT_PROPERTY_BATCH )
+		{
+			unsigned int nb = std::min( (unsigned int)KUT_PROPERTY_BATCH, nb_iter-first );
+			for( unsigned int i=0; i<nb; i++ )
+			{
+				KUT_RNG rng( seed + first + i );
+				Generate( rng, batch[i], index_type() );
+			}
+			for( unsigned int i=0; i<nb; i++ )
+				if( !Check( prop, batch[i], msg ) )
+				{
+					Fail( prop, batch[i], first+i, msg );
+					return;
+				}
+		}
+		if( kut_verbose )
+			KUT_LOG2 << "PASS, property " << name << ", " << nb_iter << " cases" << ENDL;
+		if( kut_binlog )
+			kut_ctx->AddRecord( file, line, name, KUT_OP_PROPERTY, true, data.count_test );
+	}
 
+/// Shrinks the failing case, and reports it
+	template<typename F>
+	void Fail( F& prop, const case_type& failing, unsigned int index, std::string msg )
+	{
+		case_type c( failing );
+		size_t nb_tries = 0;
+		while( nb_tries < KUT_PROPERTY_MAX_SHRINK
+			&& ShrinkArg( prop, c, nb_tries, msg, std::integral_constant<size_t,0>(), std::integral_constant<bool,sizeof...(G)==0>() ) )
+			;
+
+		KUT_TYPE& kut_data = data;
+		kut_data.count_fail++;
+		kut_data.kut_failflag = true;
+		kut_ctx->fail_file.push_back( file );
+		kut_ctx->fail_line.push_back( line );
+		if( kut_verbose )
+		{
+			KUT_LOG << "FAIL (" << kut_data.count_fail << "), on line " << line << " of file " << file
+				<< ", property " << name << ", case " << index << " of " << nb_iter << ", shrunk after " << nb_tries << " tries" << ENDL;
+			if( !msg.empty() )
+				KUT_LOG << "  -exception: " << msg << ENDL;
+		}
+		std::string counterexample = Print( c, index_type() );
+		uint64_t    seed           = kut_base_seed();
+		KUT_P_STREAM_VALUES( counterexample, seed );
+		(void)seed;
+		if( kut_binlog )
+			kut_ctx->AddRecord( file, line, name, KUT_OP_PROPERTY, false, kut_data.count_test );
+		if( kut_data.StopTestOnFail )
+		{
+			std::cout << " -premature ending of test !\n";
+			kut_data.DoQuit = true;
+			KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n";
+			KUT_LOG << " - Actual status : " << kut_data.count_test << " tests done and " << kut_data.count_fail << " failure(s)\n\n";
+			kut_premature_end( kut_data );
+		}
+	}
+};
 
+template<typename... G>
+KUT_PROPERTY_RUN<G...> kut_property( KUT_TYPE& d, const char* name, const char* file, int line, unsigned int nb_iter, const G&... g )
+{
+	return KUT_PROPERTY_RUN<G...>( d, name, file, line, nb_iter, g... );
+}
 
-/// Class Test Method end. Prints out results of test of class, and returns nb of failures (inside Test() function)
-#define KUT_CTM_END \
-	KUT_LOG << "- END Unit test of class " << kut_class_name << ", " << kut_data.count_test <<" tests done and " << kut_data.count_fail <<" failure(s)" << " TEMP "<< kut_line_counter << ENDL; \
-	if( kut_data.count_fail > 0 ) \
-	{ \
-		for( size_t kut_i=0; kut_i<kut_fail_line.size(); kut_i++ ) \
-		{ \
-			KUT_LOG << " - failed at line " << kut_fail_line.at(kut_i) \
-				<< " of file " << kut_fail_file.at(kut_i) << ENDL; \
-		} \
-	} \
-	KUT_LOG << ENDL; \
-	return kut_data
+/// Property test: checks that the property given after the macro holds for \c nb_iter cases, each argument being given by a generator
+/**
+The property follows the macro, as the parameters and the body of a lambda returning true if the property holds:
+\code
+	KUT_PROPERTY( sort_keeps_size, 100000, kut_gen_vector( kut_gen_int( -100, 100 ), 0, 50 ) )
+	( std::vector<int> v ) -> bool
+	{
+		std::vector<int> v2( v );
+		std::sort( v2.begin(), v2.end() );
+		return v2.size() == v.size();
+	};
+\endcode
+Counts as one test. On failure, the failing case is shrunk, and the smallest counterexample found is logged (see \ref property).
+*/
+#define KUT_PROPERTY( name, nb_iter, ... ) \
+	KUT_P2; \
+	kut_property( kut_data, #name, __FILE__, __LINE__, nb_iter, __VA_ARGS__ ) ->* [&]
 
 ///@}
 
 //----------------------------------------------------------------------------
-/// \name Set of macros to be used inside the test app
+/// \name Micro-benchmarks (see page \ref bench)
 //@{
 
-/// Test initialisation.
+/// duration of one sample (one batch of iterations) aimed at during calibration, in seconds
+#ifndef KUT_BENCH_SAMPLE_TIME
+	#define KUT_BENCH_SAMPLE_TIME 1e-3
+#endif
 
-#define KUT_MAIN_START \
-	KUT_MASTER kut_m; \
-	std::cout << " Test : start\n"; \
-	kut_logfile.open( KUT_FILENAME ); \
-	if( !kut_logfile.is_open() ) \
-	{ \
-		std::cout << "KUT: Unable to open log file " << KUT_FILENAME <<", exiting..." << ENDL; \
-		std::cerr << "KUT: Unable to open log file " << KUT_FILENAME <<", exiting..." << ENDL; \
-		exit(1); \
-	} \
-	if( !freopen( "stderr.txt", "wt", stderr ) ) \
-	{ \
-		std::cout << "KUT: Unable to open stderr/cerr file, exiting..." << ENDL; \
-		std::cerr << "KUT: Unable to open stderr/cerr file, exiting..." << ENDL; \
-		exit(1); \
-	} \
-	time_t t = time(0); \
-	KUT_LOG << "KUT logfile, created at " << asctime( localtime( &t ) ); \
-	KUT_LOG << " - version of KUT is " << KUT_VERSION << ENDL
+/// nb of warm-up samples, run after calibration and not measured
+#ifndef KUT_BENCH_WARMUP
+	#define KUT_BENCH_WARMUP 3
+#endif
 
+/// minimum nb of measured samples
+#ifndef KUT_BENCH_MIN_SAMPLES
+	#define KUT_BENCH_MIN_SAMPLES 10
+#endif
 
+/// Prevents the compiler from optimizing away the computation of \c value
+template<typename T>
+inline void kut_do_not_optimize( const T& value )
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile( "" : : "g"( &value ) : "memory" );
+#else
+	static const void* volatile sink;
+	sink = &value;
+#endif
+}
 
-/// Test end. Returns the total nb of failures
-#define KUT_MAIN_END \
-	KUT_LOG << "*****************************************************\n"; \
-	KUT_LOG << "Test end :"; \
-	KUT_LOG << " - Nb of U.T. = "        << kut_m.NbUnitTests  << ENDL; \
-	KUT_LOG << " - Nb U.T. Failures = "  << kut_m.NbUTFailures << ENDL; \
-	KUT_LOG << " - Total Nb of tests = " << kut_m.NbTestTot    << ENDL; \
-	KUT_LOG << " - Total Nb failures = " << kut_m.NbFailureTot << ENDL; \
-	if( kut_m.v_failed_test_name.size() ) \
-		KUT_LOG << " - List of failed tests:" << ENDL; \
-	for( size_t i=0; i<kut_m.v_failed_test_name.size(); i++ ) \
-	{ \
-		KUT_LOG << i << ": test failed for "; \
-		if( kut_m.v_failed_test_type[i]==0 ) \
-		{ \
-			KUT_LOG2 << "class"; \
-		} \
-		else \
-		{ \
-			KUT_LOG2 << "function"; \
-		} \
-		KUT_LOG2 << ": " << kut_m.v_failed_test_name[i]; \
-		KUT_LOG2 << ", see at line " << kut_m.v_failed_test_logline[i] << ENDL; \
-	} \
-	std::cout << "\n Test end :"; \
-	std::cout << "\n - Nb of U.T. = "        << kut_m.NbUnitTests; \
-	std::cout << "\n - Nb Failures = "       << kut_m.NbUTFailures; \
-	std::cout << "\n - Total Nb of tests = " << kut_m.NbTestTot; \
-	std::cout << "\n - Total Nb failures = " << kut_m.NbFailureTot << ENDL; \
-	std::cout << " See file " << KUT_FILENAME << " file\n"; \
-	return kut_m.NbFailureTot
+/// Forces the compiler to assume that all memory has been read and written (so pending writes can not be removed)
+inline void kut_clobber()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile( "" : : : "memory" );
+#else
+	std::atomic_signal_fence( std::memory_order_seq_cst );
+#endif
+}
 
+/// Prevents the compiler from optimizing away the computation of \c a, inside a benchmark
+#define KUT_DO_NOT_OPTIMIZE( a ) kut_do_not_optimize( a )
 
-/// Unit test of a class. This macro is to be used in the main test program.
-/**
-This macro tests the class 'A', i.e. :
- - creates an object of that type
- - calls the test member function on it (whose name is KUT_CUTM, but you don't really need to know this...)
-*/
-#define KUT_TEST_CLASS( A ) \
-	{ \
-		A a; \
-		kut_m.NbUnitTests++; \
-		KUT_LOG << "*****************************************************\n"; \
-		KUT_LOG << "* Unit test no " << kut_m.NbUnitTests << ", testing class " << #A << " TEMP "<< kut_line_counter << ENDL; \
-		KUT_TYPE kut_data= a.KUT_CUTM(); \
-		std::cout << kut_m.NbUnitTests << " : Unit test of class " << #A << " : " << kut_data.count_test <<  " tests : "; \
-		kut_m.NbTestTot += kut_data.count_test; \
-		if( kut_data.count_fail == 0 ) \
-			std::cout << " success\n"; \
-		else \
-		{ \
-			std::cout << kut_data.count_fail << " failure(s)\n"; \
-			kut_m.NbFailureTot += kut_data.count_fail; \
-			kut_m.NbUTFailures++; \
-			kut_m.v_failed_test_name.push_back( #A ); \
-			kut_m.v_failed_test_type.push_back( 0 ); \
-			kut_m.v_failed_test_logline.push_back( kut_line_counter ); \
-		} \
-	}
+/// Prevents the compiler from removing memory writes done inside a benchmark
+#define KUT_CLOBBER() kut_clobber()
 
-/// Call of a function dedicated to the test of a global function.
-/// This macro is to be used in the main test program.
+//-------------------------------------------------------------------------------------------
+/// Internal data structure used, runs a benchmark (see KUT_BENCH_START)
 /**
-Please note that the function \c a DOES NOT need to be declared, the macro takes care of this.
+The measured code is run by batches of \c batch iterations, each batch being one sample:
+- calibration: the batch size is doubled until a sample lasts at least KUT_BENCH_SAMPLE_TIME (or \c min_time / KUT_BENCH_MIN_SAMPLES, if shorter),
+- warm-up: KUT_BENCH_WARMUP samples are run and discarded,
+- measure: samples are recorded until there are at least KUT_BENCH_MIN_SAMPLES of them, \c min_iter iterations, and \c min_time seconds.
 */
-#define KUT_TEST_FUNC( a ) \
-	{ \
-		kut_m.NbUnitTests++; \
-		KUT_LOG << "*****************************************************\n"; \
-		KUT_LOG << "* Unit test no " << kut_m.NbUnitTests << ", testing function " << #a << " TEMP " << kut_line_counter << ENDL; \
-		KUT_TYPE a(); \
-		KUT_TYPE kut_data = a(); \
-		std::cout << kut_m.NbUnitTests << " : Unit test of function " << #a << " : " << kut_data.count_test <<  " tests : "; \
-		kut_m.NbTestTot += kut_data.count_test; \
-		if( kut_data.count_fail == 0 ) \
-			std::cout << " success\n"; \
-		else \
-		{ \
-			std::cout << kut_data.count_fail << " failure(s)\n"; \
-			kut_m.NbFailureTot += kut_data.count_fail; \
-			kut_m.NbUTFailures++; \
-			kut_m.v_failed_test_name.push_back( #a ); \
-			kut_m.v_failed_test_type.push_back( 1 ); \
-			kut_m.v_failed_test_logline.push_back( kut_line_counter ); \
-		} \
+struct KUT_BENCH
+{
+	enum { CALIBRATION, WARMUP, MEASURE, DONE };
+
+	KUT_BENCH_RESULT    res;
+	size_t              min_iter;
+	double              min_time;
+	double              sample_time; ///< target duration of a sample
+	int                 phase;
+	size_t              nb_warmup;
+	double              total_time;  ///< total measured time
+	std::vector<double> v_sample;    ///< duration of one iteration, for each sample
+	std::chrono::steady_clock::time_point t0;
+
+	KUT_BENCH( const std::string& name, size_t min_it, double min_t )
+	{
+		res.name    = name;
+		res.batch   = 1;
+		min_iter    = min_it;
+		min_time    = min_t;
+		sample_time = std::min<double>( KUT_BENCH_SAMPLE_TIME, min_time / KUT_BENCH_MIN_SAMPLES );
+		phase       = CALIBRATION;
+		nb_warmup   = 0;
+		total_time  = 0.;
 	}
 
-///@}
-
-//----------------------------------------------------------------------------
-/// \name two macros for testing of a function
-//@{
-
-/// Configures everything for test of function \c a
-/** Actually, the argument is only for documentation purposes, not used at present
-*/
-#define KUT_FT_START(a) \
-	KUT_TYPE kut_data; \
-	kut_fail_file.clear(); \
-	kut_fail_line.clear(); \
-	KUT_LOG << "- BEGIN unit test of function '" << #a << "()' through test function "<< __FUNCTION__ << " TEMP "<< kut_line_counter << ENDL; \
-	std::cerr << "- BEGIN unit test of function '" << #a << "()' through test function "<< __FUNCTION__ << ENDL;
-
+/// Returns false when enough samples have been measured
+	bool Next() const
+	{
+		return phase != DONE;
+	}
 
-/// End of test function
-#define KUT_FT_END \
-	KUT_LOG << "\n- END of test function, "<< kut_data.count_test <<" tests and " << kut_data.count_fail<<" failure(s)\n\n"; \
-	return kut_data
+	void Start()
+	{
+		t0 = std::chrono::steady_clock::now();
+	}
 
-/// Useful for using test functions inside a class test, see class1.cpp for an example
-#define KUT_EXECFUNC( a ) \
-	if( kut_verbose ) \
-		KUT_LOG << "\n - Starting function : " << #a << ENDL; \
-	kut_data.count_test1++; \
-	kut_data.count_test2 = 0; \
-	kut_data = a; \
-	if( kut_data.DoQuit == true ) \
-		return kut_data;
-///@}
+	void Stop()
+	{
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - t0;
+		double elapsed = d.count();
+		switch( phase )
+		{
+			case CALIBRATION:
+				if( elapsed >= sample_time )
+					phase = KUT_BENCH_WARMUP > 0 ? WARMUP : MEASURE;
+				else
+					res.batch *= 2;
+			break;
+			case WARMUP:
+				if( ++nb_warmup >= KUT_BENCH_WARMUP )
+					phase = MEASURE;
+			break;
+			case MEASURE:
+				v_sample.push_back( elapsed / res.batch );
+				total_time += elapsed;
+				if( v_sample.size() >= KUT_BENCH_MIN_SAMPLES && v_sample.size()*res.batch >= min_iter && total_time >= min_time )
+					phase = DONE;
+			break;
+		}
+	}
 
-//----------------------------------------------------------------------------
-/// \name Macros allowing iterating several tests (see page \ref iterative)
-//@{
+/// Computes the statistics and prints them in the log file
+	void Report()
+	{
+		std::sort( v_sample.begin(), v_sample.end() );
+		size_t n = v_sample.size();
+		res.nb_samples = n;
+		res.nb_iter    = n * res.batch;
+		res.min        = v_sample[0];
+		res.median     = n%2 ? v_sample[n/2] : ( v_sample[n/2-1] + v_sample[n/2] ) / 2.;
+		res.p99        = v_sample[ std::min( n-1, (size_t)std::ceil( 0.99*n ) - 1 ) ];
+		double sum = 0., sum2 = 0.;
+		for( size_t i=0; i<n; i++ )
+		{
+			sum  += v_sample[i];
+			sum2 += v_sample[i] * v_sample[i];
+		}
+		res.mean   = sum / n;
+		res.stddev = std::sqrt( std::max( 0., sum2/n - res.mean*res.mean ) );
+
+		KUT_LOG << " * Benchmark \"" << res.name << "\": " << res.nb_iter << " iterations (" << n << " samples of " << res.batch << ")"
+			<< ", min: "    << kut_format_duration( res.min )
+			<< ", median: " << kut_format_duration( res.median )
+			<< ", p99: "    << kut_format_duration( res.p99 )
+			<< ", stddev: " << kut_format_duration( res.stddev ) << ENDL;
+	}
+};
 
-/// Start a loop
-#define KUT_LOOP_START( nb_iter ) \
+/// Starts a benchmark named \c name (a string), the code between this and KUT_BENCH_END is the measured code
+/**
+It is run at least \c min_iter times, during at least \c min_time seconds. The iteration index is \c kut_i.
+*/
+#define KUT_BENCH_START( name, min_iter, min_time ) \
 	{ \
-		int kut_loop_line = __LINE__; \
-		if( kut_verbose ) \
-			KUT_LOG << std::dec<< " * Test " << ++kut_data.count_test << " (loop type) (" << kut_data.count_test1 << "." << kut_data.count_test2 <<")\n"; \
-		std::vector<unsigned int> kut_loop_fails; \
-		std::vector<std::string>  kut_loop_expr_a; \
-		std::vector<std::string>  kut_loop_expr_b; \
-		std::vector<std::string>  kut_loop_expr_op; \
-		unsigned int kut_loop_nb_iter = nb_iter; \
-		bool kut_fail_flag = false; \
-		for( unsigned int kut_i=0; kut_i<nb_iter; kut_i++ ) \
+		KUT_BENCH kut_bench( name, min_iter, min_time ); \
+		while( kut_bench.Next() ) \
 		{ \
-			unsigned int kut_loop_macro_count = 0;
+			const size_t kut_bench_batch = kut_bench.res.batch; \
+			kut_bench.Start(); \
+			for( size_t kut_i=0; kut_i<kut_bench_batch; kut_i++ ) \
+			{
 
-/// End a loop
-#define KUT_LOOP_END \
-		} \
-		if( kut_verbose ) \
-		{ \
-			KUT_LOG << (kut_fail_flag ? "FAIL" : "PASS") << ", " << kut_loop_nb_iter << " iterations, at line "<< kut_loop_line << ENDL; \
-			for( size_t kut_i=0; kut_i<kut_loop_fails.size(); kut_i++ ) \
-			{ \
-				KUT_LOG << "   - subtest " << kut_data.count_test << "." << kut_i+1 << ", expr: " << kut_loop_expr_a.at(kut_i); \
-				KUT_LOG2 << "  " << kut_loop_expr_op.at(kut_i) << " " << kut_loop_expr_b.at(kut_i); \
-				KUT_LOG2 << ", failed: "<< kut_loop_fails.at(kut_i); \
-				KUT_LOG2 << " over " << kut_loop_nb_iter << " (" << 100.0*kut_loop_fails.at(kut_i)/kut_loop_nb_iter<<" %)\n"; \
+/// Ends a benchmark, and prints its statistics in the log file
+#define KUT_BENCH_END \
 			} \
+			kut_bench.Stop(); \
 		} \
-		if( kut_fail_flag == true ) \
-		{ \
-			kut_data.count_fail++; \
-			kut_fail_file.push_back( __FILE__ ); \
-			kut_fail_line.push_back( kut_loop_line ); \
-			if( kut_data.StopTestOnFail ) \
-			{ \
-				std::cout << " -premature ending of test !\n"; \
-				kut_data.DoQuit = true; \
-				KUT_LOG << "\n- PREMATURE ENDING of test due to failure!\n"; \
-				KUT_LOG << " - in function : " << __PRETTY_FUNCTION__ << ENDL; \
-				KUT_LOG << " - Actual status : " << kut_data.count_test<<" tests done and " << kut_data.count_fail<<" failure(s)\n\n"; \
-				exit(1); \
-				return kut_data; \
-			} \
-		}\
+		kut_bench.Report(); \
+		kut_data.v_bench.push_back( kut_bench.res ); \
 	}
 
-/// private macro 1.1
-#define KUT_LOOP_P11( expr, op ) \
-	if( kut_i == 0 ) \
-	{ \
-		kut_loop_expr_a.push_back( #expr ); \
-		kut_loop_expr_b.push_back( "" ); \
-		kut_loop_expr_op.push_back( op ); \
-		kut_loop_fails.push_back( 0 ); \
+/// Writes the benchmark compared by KUT_PERF_LESS in the log file (verbose mode), \c median being negative if not run, \c baseline 0 if none
+KUT_COLD inline void kut_perf_log( const std::string& name, double tolerance_pct, double median, double baseline )
+{
+	KUT_LOG2 << "benchmark \"" << name << "\", ";
+	if( median < 0. )
+		KUT_LOG2 << "not run";
+	else
+	{
+		KUT_LOG2 << "median " << kut_format_duration( median );
+		if( baseline > 0. )
+			KUT_LOG2 << ", baseline " << kut_format_duration( baseline ) << " (+" << tolerance_pct << "% allowed)";
+		else
+			KUT_LOG2 << ", no baseline";
 	}
+	KUT_LOG2 << ": ";
+}
 
-/// private macro 1.2
-#define KUT_LOOP_P12( expr1, op, expr2 ) \
-	if( kut_i == 0 ) \
-	{ \
-		kut_loop_expr_a.push_back( #expr1 ); \
-		kut_loop_expr_b.push_back( #expr2 ); \
-		kut_loop_expr_op.push_back( op ); \
-		kut_loop_fails.push_back( 0 ); \
-	}
+/// Returns true if the median duration of the benchmark \c name (run before by the current unit test) is no more than
+/// \c tolerance_pct percent above its baseline, or if there is no baseline for it
+inline bool kut_perf_compare( const KUT_TYPE& kut_data, const std::string& name, double tolerance_pct )
+{
+	double median   = -1.;
+	double baseline = 0.;
+	for( size_t i=0; i<kut_data.v_bench.size(); i++ )
+		if( kut_data.v_bench[i].name == name )
+			median = kut_data.v_bench[i].median;
+	std::map<std::string,double>::const_iterator it = kut_baseline.find( name );
+	if( median >= 0. && it != kut_baseline.end() )
+		baseline = it->second;
+#ifndef KUT_FAST_MODE
+	if( kut_verbose )
+		kut_perf_log( name, tolerance_pct, median, baseline );
+#endif
+	if( median < 0. )
+		return false;
+	return baseline <= 0. || median <= baseline * ( 1. + tolerance_pct/100. );
+}
 
-/// private macro 2
-#define KUT_LOOP_P2 \
-	{ \
-		kut_loop_fails[kut_loop_macro_count]++; \
-		kut_fail_flag = true; \
-	} \
-	kut_loop_macro_count++ \
+/// Testing that the benchmark \c name (a string) is not slower than its baseline by more than \c tolerance_pct percent (see \ref bench)
+#define KUT_PERF_LESS( name, tolerance_pct ) \
+	KUT_P_TEST( kut_perf_compare( kut_data, name, tolerance_pct ), KUT_OP_PERF, "benchmark", "", 0 )
 
+//-------------------------------------------------------------------------------------------
+/// Name of a hardware performance counter, as written in the log file
+inline const char* kut_pc_name( int pc )
+{
+	static const char* names[] = { "instructions", "cycles", "cache misses", "branch misses" };
+	return pc >= 0 && pc < KUT_PC_NB ? names[pc] : "?";
+}
 
-/// Testing if expression evaluates to true, inside a test loop
-#define KUT_LOOP_TRUE( a ) \
-	{ \
-		KUT_LOOP_P11( a, "TRUE" ); \
-		if( (a)==false ) \
-			KUT_LOOP_P2; \
+/// Internal data structure used, reads the hardware performance counters of the current thread (see KUT_PERFCOUNT_START)
+/**
+The counters are opened as one group with perf_event_open(), so they are enabled and disabled together, user space only.
+A counter that can not be opened (no PMU, as in most virtual machines, or not permitted, see \c /proc/sys/kernel/perf_event_paranoid)
+is not available, and its value is negative. If the counters had to be multiplexed, the values are scaled by the kernel timings.
+
+The measured code is run once before, not measured, so the counts do not hold the first call effects (cold cache, lazy binding, ...).
+*/
+struct KUT_PERFCOUNT
+{
+	KUT_PERFCOUNT_RESULT res;
+	int fd[KUT_PC_NB];
+	int leader;              ///< first counter opened, the group leader, -1 if none
+
+	KUT_PERFCOUNT( const std::string& name, size_t nb_calls )
+	{
+		res.name     = name;
+		res.nb_calls = std::max( nb_calls, size_t(1) );
+		leader = -1;
+		for( int i=0; i<KUT_PC_NB; i++ )
+		{
+			res.value[i] = -1.;
+			fd[i] = Open( i );
+			if( leader < 0 )
+				leader = fd[i];
+		}
+	}
+	~KUT_PERFCOUNT()
+	{
+#ifdef KUT_HAS_PERFCOUNT
+		for( int i=0; i<KUT_PC_NB; i++ )
+			if( fd[i] >= 0 )
+				close( fd[i] );
+#endif
 	}
 
-/// Testing if expression evaluates to false, inside a test loop
-#define KUT_LOOP_FALSE( a ) \
-	{ \
-		KUT_LOOP_P11( a, "FALSE" ); \
-		if( (a)==true ) \
-			KUT_LOOP_P2; \
+/// Opens the counter \c pc (see KUT_PC), returns -1 on failure
+	int Open( int pc )
+	{
+#ifdef KUT_HAS_PERFCOUNT
+		static const uint64_t config[] = { PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+		perf_event_attr attr;
+		std::memset( &attr, 0, sizeof(attr) );
+		attr.size           = sizeof(attr);
+		attr.type           = PERF_TYPE_HARDWARE;
+		attr.config         = config[pc];
+		attr.disabled       = ( leader < 0 );
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)syscall( SYS_perf_event_open, &attr, 0, -1, leader, 0 );
+#else
+		(void)pc;
+		return -1;
+#endif
 	}
 
+/// Starts counting, for the measured calls only (\c pass is 0 for the unmeasured call)
+	void Start( int pass )
+	{
+#ifdef KUT_HAS_PERFCOUNT
+		if( pass && leader >= 0 )
+		{
+			ioctl( leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+			ioctl( leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+		}
+#else
+		(void)pass;
+#endif
+	}
 
-/// Testing is the two arguments are equal, using their '==' operator (needs to be defined)
-#define KUT_LOOP_EQU( a, b ) \
-	{ \
-		KUT_LOOP_P12( a, "EQUAL", b ); \
-		if( false == ((a) == (b)) ) \
-			KUT_LOOP_P2; \
+/// Stops counting, and reads the counters
+	void Stop( int pass )
+	{
+#ifdef KUT_HAS_PERFCOUNT
+		if( !pass || leader < 0 )
+			return;
+		ioctl( leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+		for( int i=0; i<KUT_PC_NB; i++ )
+		{
+			uint64_t v[3]; // value, time enabled, time running
+			if( fd[i] < 0 || read( fd[i], v, sizeof(v) ) != sizeof(v) || v[2] == 0 )
+				continue;
+			double count = v[2] < v[1] ? double( v[0] ) * v[1] / v[2] : double( v[0] );
+			res.value[i] = count / res.nb_calls;
+		}
+#else
+		(void)pass;
+#endif
 	}
 
-/// Testing is the two arguments are different, using their '!=' operator (needs to be defined)
-#define KUT_LOOP_DIFF( a, b ) \
-	{ \
-		KUT_LOOP_P12( a, "DIFF", b ); \
-		if( false == ((a) != (b)) ) \
-			KUT_LOOP_P2; \
+/// Prints the counts per call in the log file
+	void Report() const
+	{
+		KUT_LOG << " * Counters \"" << res.name << "\": " << res.nb_calls << " calls";
+		if( leader < 0 )
+			KUT_LOG2 << ", not available";
+		for( int i=0; i<KUT_PC_NB; i++ )
+			if( res.value[i] >= 0. )
+				KUT_LOG2 << ", " << kut_pc_name( i ) << ": " << res.value[i];
+		if( leader >= 0 )
+			KUT_LOG2 << " per call";
+		KUT_LOG2 << ENDL;
 	}
+};
 
-/// Testing ordering of 2 objects, by using the '<' operator (needs to be defined)
-#define KUT_LOOP_LESS( a, b ) \
+/// Starts a scope measured with the hardware performance counters, named \c name (a string), the code between this and KUT_PERFCOUNT_END
+/**
+is run once, then \c nb times while counting. The call index is \c kut_i. See \ref perfcount.
+*/
+#define KUT_PERFCOUNT_START( name, nb ) \
 	{ \
-		KUT_LOOP_P12( a, "LESS", b ); \
-		if( false == ((a) < (b)) ) \
-			KUT_LOOP_P2; \
+		KUT_PERFCOUNT kut_perfcount( name, nb ); \
+		for( int kut_pass=0; kut_pass<2; kut_pass++ ) \
+		{ \
+			const size_t kut_pc_nb = kut_pass ? kut_perfcount.res.nb_calls : 1; \
+			kut_perfcount.Start( kut_pass ); \
+			for( size_t kut_i=0; kut_i<kut_pc_nb; kut_i++ ) \
+			{
+
+/// Ends a scope measured with the hardware performance counters, and prints the counts per call in the log file
+#define KUT_PERFCOUNT_END \
+			} \
+			kut_perfcount.Stop( kut_pass ); \
+		} \
+		kut_perfcount.Report(); \
+		kut_data.v_perfcount.push_back( kut_perfcount.res ); \
 	}
 
+/// Writes the counter compared by KUT_PERFCOUNT_LESS in the log file (verbose mode), \c value being negative if not available
+KUT_COLD inline void kut_perfcount_log( const std::string& name, int pc, double max, double value, bool found )
+{
+	KUT_LOG2 << "counters \"" << name << "\", ";
+	if( !found )
+		KUT_LOG2 << "not run";
+	else if( value < 0. )
+		KUT_LOG2 << kut_pc_name( pc ) << " not available";
+	else
+		KUT_LOG2 << kut_pc_name( pc ) << " per call: " << value << " (max " << max << ")";
+	KUT_LOG2 << ": ";
+}
+
+/// Returns true if the counter \c pc (see KUT_PC) of the scope \c name (run before by the current unit test) is at most \c max per call,
+/// or if this counter is not available. Returns false if the scope was not run
+inline bool kut_perfcount_compare( const KUT_TYPE& kut_data, const std::string& name, int pc, double max )
+{
+	double value = -1.;
+	bool found = false;
+	for( size_t i=0; i<kut_data.v_perfcount.size(); i++ )
+		if( kut_data.v_perfcount[i].name == name )
+		{
+			found = true;
+			value = kut_data.v_perfcount[i].value[pc];
+		}
+#ifndef KUT_FAST_MODE
+	if( kut_verbose )
+		kut_perfcount_log( name, pc, max, value, found );
+#endif
+	if( !found )
+		return false;
+	return value < 0. || value <= max;
+}
+
+/// Testing that the counter \c pc (see KUT_PC) of the scope \c name (a string) is at most \c max per call (see \ref perfcount)
+#define KUT_PERFCOUNT_LESS( name, pc, max ) \
+	KUT_P_TEST( kut_perfcount_compare( kut_data, name, pc, max ), KUT_OP_PERFCOUNT, "counters", "", 0 )
+
 ///@}
 
 /// returns true if the last test failed
@@ -1163,12 +7067,16 @@ and if an exception happens, it will be catched and increases the error counters
 	try \
 	{ \
 		a; \
-		KUT_LOG2 << "PASS: expression: " << #a << ": no exception throwed" << std::endl; \
+		KUT_LOG2 << "PASS: expression: " << #a << ": no exception throwed" << ENDL; \
+	} \
+	catch( const KUT_STOP_TEST& ) \
+	{ \
+		throw; \
 	} \
 	catch( const std::exception& e ) \
 	{ \
 		KUT_P_FAILURE \
-		KUT_LOG2 << ", exception msg: " << e.what() << std::endl; \
+		KUT_LOG2 << ", exception msg: " << e.what() << ENDL; \
 	} \
 	catch( ... ) \
 	{ \
@@ -1176,7 +7084,8 @@ and if an exception happens, it will be catched and increases the error counters
 		KUT_LOG << "\nKUT: unhandled exception !!!\n"; \
 		KUT_P_FAILURE \
 		throw; \
-	}
+	} \
+	KUT_P_RECORD( KUT_OP_NOTHROW, #a )
 
 /// A macro for running a function and checking that it DOES throw a (text) exception
 /**
@@ -1189,7 +7098,11 @@ and exception will be thrown again.
 	{ \
 		a; \
 		KUT_P_FAILURE \
-		KUT_LOG2 << ", statement did NOT throw exception" << std::endl; \
+		KUT_LOG2 << ", statement did NOT throw exception" << ENDL; \
+	} \
+	catch( const KUT_STOP_TEST& ) \
+	{ \
+		throw; \
 	} \
 	catch( const std::exception& e ) \
 	{ \
@@ -1201,7 +7114,8 @@ and exception will be thrown again.
 		KUT_LOG << "KUT: unhandled exception !!!\n"; \
 		KUT_P_FAILURE \
 		throw; \
-	}
+	} \
+	KUT_P_RECORD( KUT_OP_THROW, #a )
 
 
 //----------------------------------------------------------------------------
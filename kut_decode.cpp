@@ -0,0 +1,190 @@
+/**
+\file kut_decode.cpp
+\brief kut-decode: reads a binary log file written by a kut test program (see \ref binlog) and prints it as text.
+
+Usage:
+\verbatim
+kut-decode [--summary] [--failures] [--filter=text] file
+\endverbatim
+ - default: prints all the tests, in a format close to the text log file
+ - \c --summary: only prints one line per unit test
+ - \c --failures: only prints the failed tests
+ - \c --filter=text: only prints the unit tests whose name contains \c text
+
+Part of kut, see https://github.com/skramm/kut
+*/
+
+#include "kut.h"
+
+#include <fstream>
+#include <iomanip>
+
+KUT_ALLOC;
+
+//-------------------------------------------------------------------------------------------
+/// Decoded unit test
+struct DEC_UNIT_TEST
+{
+	uint32_t id;
+	uint32_t name_id;
+	uint32_t type;
+	int32_t  count_test;
+	int32_t  count_fail;
+	std::vector<KUT_BIN_RECORD> v_record;
+};
+
+//-------------------------------------------------------------------------------------------
+/// Reads the whole file, returns false and prints a message on error
+bool
+ReadBinLog( const char* fname, std::vector<std::string>& v_string, std::vector<DEC_UNIT_TEST>& v_ut )
+{
+	std::ifstream f( fname, std::ios::binary );
+	if( !f.is_open() )
+	{
+		std::cerr << "kut-decode: unable to open file " << fname << '\n';
+		return false;
+	}
+	char magic[sizeof( KUT_BIN_MAGIC )];
+	uint32_t record_size = 0;
+	f.read( magic, sizeof(magic) );
+	f.read( (char*)&record_size, sizeof(uint32_t) );
+	if( !f || std::string( magic ) != KUT_BIN_MAGIC )
+	{
+		std::cerr << "kut-decode: " << fname << " is not a kut binary log file\n";
+		return false;
+	}
+	if( record_size != sizeof( KUT_BIN_RECORD ) )
+	{
+		std::cerr << "kut-decode: unsupported record size " << record_size << '\n';
+		return false;
+	}
+
+	uint32_t chunk;
+	while( f.read( (char*)&chunk, sizeof(uint32_t) ) )
+	{
+		switch( chunk )
+		{
+			case KUT_BIN_STRING:
+			{
+				uint32_t head[2];
+				f.read( (char*)head, sizeof(head) );
+				std::string s( head[1], ' ' );
+				if( head[1] )
+					f.read( &s[0], head[1] );
+				if( head[0] >= v_string.size() )
+					v_string.resize( head[0]+1 );
+				v_string[head[0]] = s;
+			}
+			break;
+			case KUT_BIN_UNIT_TEST:
+			{
+				uint32_t head[5];
+				f.read( (char*)head, sizeof(head) );
+				DEC_UNIT_TEST ut;
+				ut.id         = head[0];
+				ut.name_id    = head[1];
+				ut.type       = head[2];
+				ut.count_test = (int32_t)head[3];
+				ut.count_fail = (int32_t)head[4];
+				v_ut.push_back( ut );
+			}
+			break;
+			case KUT_BIN_RECORDS:
+			{
+				uint32_t nb = 0;
+				f.read( (char*)&nb, sizeof(uint32_t) );
+				if( v_ut.empty() )
+				{
+					std::cerr << "kut-decode: records without unit test\n";
+					return false;
+				}
+				std::vector<KUT_BIN_RECORD>& v = v_ut.back().v_record;
+				v.resize( nb );
+				if( nb )
+					f.read( (char*)&v[0], nb*sizeof(KUT_BIN_RECORD) );
+			}
+			break;
+			default:
+				std::cerr << "kut-decode: invalid chunk type " << chunk << '\n';
+				return false;
+		}
+		if( !f )
+		{
+			std::cerr << "kut-decode: unexpected end of file\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------------------
+int
+main( int argc, const char** argv )
+{
+	bool summary = false, failures = false;
+	std::string filter;
+	const char* fname = 0;
+	for( int i=1; i<argc; i++ )
+	{
+		std::string arg( argv[i] );
+		if( arg == "--summary" )
+			summary = true;
+		else if( arg == "--failures" )
+			failures = true;
+		else if( arg.compare( 0, 9, "--filter=" ) == 0 )
+			filter = arg.substr( 9 );
+		else if( arg[0] != '-' )
+			fname = argv[i];
+		else
+		{
+			std::cerr << "kut-decode: unknown option " << arg << '\n';
+			return 2;
+		}
+	}
+	if( !fname )
+	{
+		std::cerr << "usage: kut-decode [--summary] [--failures] [--filter=text] file\n";
+		return 2;
+	}
+
+	std::vector<std::string>   v_string;
+	std::vector<DEC_UNIT_TEST> v_ut;
+	if( !ReadBinLog( fname, v_string, v_ut ) )
+		return 2;
+
+	int nb_test_tot = 0, nb_fail_tot = 0, nb_ut = 0, nb_ut_fail = 0;
+	for( size_t i=0; i<v_ut.size(); i++ )
+	{
+		const DEC_UNIT_TEST& ut = v_ut[i];
+		const std::string& name = ut.name_id < v_string.size() ? v_string[ut.name_id] : "?";
+		if( !filter.empty() && name.find( filter ) == std::string::npos )
+			continue;
+		nb_ut++;
+		nb_test_tot += ut.count_test;
+		nb_fail_tot += ut.count_fail;
+		if( ut.count_fail )
+			nb_ut_fail++;
+		if( failures && !ut.count_fail )
+			continue;
+
+		std::cout << "Unit test " << ut.id << ": " << ( ut.type ? "function " : "class " ) << name
+			<< ": " << ut.count_test << " tests, " << ut.count_fail << " failures\n";
+		if( summary )
+			continue;
+		for( size_t j=0; j<ut.v_record.size(); j++ )
+		{
+			const KUT_BIN_RECORD& r = ut.v_record[j];
+			if( failures && r.pass )
+				continue;
+			std::cout << ( r.pass ? " PASS" : " FAIL" )
+				<< " #" << r.index
+				<< ' ' << std::setw(7) << std::left << kut_op_name( r.op ) << std::right
+				<< ' ' << ( r.file_id < v_string.size() ? v_string[r.file_id] : "?" ) << ':' << r.line
+				<< ", expression: " << ( r.expr_id < v_string.size() ? v_string[r.expr_id] : "?" )
+				<< ", t=" << std::fixed << std::setprecision(6) << r.timestamp * 1E-9 << " s\n";
+		}
+	}
+	std::cout << "Total: " << nb_ut << " unit tests, " << nb_ut_fail << " failed, "
+		<< nb_test_tot << " tests, " << nb_fail_tot << " failures\n";
+	return nb_fail_tot ? 1 : 0;
+}